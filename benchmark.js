@@ -16,25 +16,17 @@ function repeatLimit(fn, limit, times, callback) {
     var start = new Date().getTime(), iterations = 0, active = 0, started = 0, finished = 0, failed = false;
 
     var env = new eos.Environment(),
-        connections = []
+        connections
 
-    for (var i = 0; i < limit; i++)
-        connections.push(i)
-
-    Async.mapLimit(connections, 16, function(_, cb) {
-        var conn = env.newConnection()
-        conn.driverConnect(connectionString, function(err) {
-            return cb(err, !err && conn);
-        })
-    }, function(err, results) {
-        if (err) {
-            return callback(err)
-            
-            connections.forEach(function(c) {
+    env.openMany(connectionString, limit, 16, function(err, results, errors) {
+        if (errors.length) {
+            results.forEach(function(c) {
                 c.disconnect(function() {
                     c.free()
                 })
             })
+
+            return callback(errors[0])
         }
         
         connections = results
@@ -4,27 +4,48 @@
       'target_name' : 'eos',
       'sources' : [ 
         'src/buffer.hpp', 'src/buffer.cpp',
+        'src/completion.hpp',
+        'src/datasink.hpp', 'src/datasink.cpp',
+        'src/decoder.hpp', 'src/decoder.cpp',
         'src/handle.hpp', 'src/handle.cpp',
+        'src/kernels.hpp', 'src/kernels.cpp',
         'src/eos.hpp', 'src/eos.cpp',
         'src/env.hpp', 'src/env.cpp',
+          'src/env.newConnection.cpp',
+          'src/env.openMany.cpp',
         'src/conn.hpp', 'src/conn.cpp',
           'src/conn.connect.cpp',
           'src/conn.driverConnect.cpp',
           'src/conn.disconnect.cpp',
           'src/conn.browseConnect.cpp',
+          'src/conn.newStatement.cpp',
+          'src/conn.reset.cpp',
+          'src/conn.prepareCached.cpp',
+          'src/conn.setAutoCommit.cpp',
+          'src/conn.endTran.cpp',
+        'src/connpool.hpp', 'src/connpool.cpp',
         'src/operation.hpp', 'src/operation.cpp',
+        'src/paramarray.hpp', 'src/paramarray.cpp',
+        'src/paramblock.hpp', 'src/paramblock.cpp',
         'src/parameter.hpp', 'src/parameter.cpp',
+        'src/pool.hpp', 'src/pool.cpp',
+        'src/result.hpp', 'src/result.cpp',
         'src/stmt.hpp', 'src/stmt.cpp',
+          'src/stmt.closeCursor.cpp',
           'src/stmt.describeCol.cpp',
           'src/stmt.execDirect.cpp',
           'src/stmt.execute.cpp',
+          'src/stmt.executeBatch.cpp',
+          'src/stmt.executeColumns.cpp',
           'src/stmt.fetch.cpp',
+          'src/stmt.fetchBlock.cpp',
           'src/stmt.getData.cpp',
           'src/stmt.moreResults.cpp',
           'src/stmt.numResultCols.cpp',
           'src/stmt.paramData.cpp',
           'src/stmt.prepare.cpp',
-          'src/stmt.putData.cpp'
+          'src/stmt.putData.cpp',
+          'src/stmt.putDataStream.cpp'
       ],
       'defines' : [
         'UNICODE', 'XXXEOS_ENABLE_ASYNC_NOTIFICATIONS'
@@ -1 +1,4 @@
 module.exports = require("./bindings");
+
+require("./streams");
+require("./transactions");
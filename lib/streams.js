@@ -0,0 +1,54 @@
+var bindings = require("./bindings");
+
+// Sends the contents of a Readable stream as the value of a data-at-execution parameter,
+// once paramData() has returned that parameter. The chunks are queued natively and sent
+// by a single operation, pausing the stream when the queue is full. The callback receives
+// the same arguments as the paramData() callback, for the next parameter (if any).
+// If the stream errors, or is destroyed before it ends, the statement is cancelled.
+bindings.Statement.prototype.putStream = function (param, readable, callback) {
+    var streamError, ended = false;
+
+    var sink = this.putDataStream(param, function (err, nextParam, needData, dataAvailable) {
+        readable.removeListener("data", onData);
+        readable.removeListener("end", onEnd);
+        readable.removeListener("error", onError);
+        readable.removeListener("close", onClose);
+
+        callback(streamError || err, nextParam, needData, dataAvailable);
+    });
+
+    sink.ondrain = function () {
+        readable.resume();
+    };
+
+    function onData(chunk) {
+        if (typeof chunk === "string")
+            chunk = new Buffer(chunk);
+
+        if (!sink.write(chunk))
+            readable.pause();
+    }
+
+    function onEnd() {
+        ended = true;
+        sink.end();
+    }
+
+    function onError(err) {
+        streamError = err;
+        sink.abort();
+    }
+
+    function onClose() {
+        if (ended || streamError)
+            return;
+
+        streamError = new Error("The stream was closed before it ended");
+        sink.abort();
+    }
+
+    readable.on("data", onData);
+    readable.on("end", onEnd);
+    readable.on("error", onError);
+    readable.on("close", onClose);
+};
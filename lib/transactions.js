@@ -0,0 +1,208 @@
+var bindings = require("./bindings");
+
+// Runs units of work (each usually one statement) on a connection in shared transactions,
+// committing after every `statements` units or `interval` milliseconds, whichever comes
+// first, instead of after each one. Each unit's callback is called once the transaction
+// containing it has been committed, or has failed to commit. Work added while a commit is
+// in progress, or due, waits for it, since the transaction must not change while it is 
+// committed.
+function GroupCommit(conn, options) {
+    options = options || {};
+
+    this.connection = conn;
+    this.statements = options.statements === undefined ? 100 : options.statements;
+    this.interval = options.interval === undefined ? 50 : options.interval;
+
+    if (!(this.statements >= 1))
+        throw new RangeError("statements must be at least 1");
+    if (!(this.interval >= 0))
+        throw new RangeError("interval must be a non-negative number of milliseconds");
+
+    this.running = 0;           // Units of work in progress
+    this.committing = false;
+    this.pendingCommit = false; // Whether to commit once the work in progress has finished
+    this.closed = false;
+    this.started = false;       // Whether autocommit has been turned off
+    this.done = [];             // Callbacks of the units in the current transaction
+    this.flushing = [];         // Callbacks of flushes waiting for the current transaction
+    this.waiting = [];          // Work (and flushes) added during a commit, or when the transaction is full
+    this.timer = null;
+}
+
+function callAll(callbacks, err) {
+    callbacks.forEach(function (cb) { cb(err); });
+}
+
+// Runs work(callback), where work runs a statement on the connection and calls back with
+// an error, if any. callback(err) is called when the work has been committed.
+GroupCommit.prototype.run = function (work, callback) {
+    if (this.closed)
+        throw new Error("The group commit has been closed");
+
+    if (this.committing || this.pendingCommit || !this.started || this._full()) {
+        this.waiting.push({ work: work, callback: callback });
+        if (!this.started && !this.committing)
+            this._begin();
+        return;
+    }
+
+    this._start(work, callback);
+};
+
+// Commits the work run so far, once it has finished, then calls callback(err), after the
+// callbacks of the units it committed. Work run after the flush goes in the next transaction.
+GroupCommit.prototype.flush = function (callback) {
+    callback = callback || function () {};
+
+    // Work which is waiting has to be started, and committed, first.
+    if (this.waiting.length)
+        return this.waiting.push({ flush: callback });
+
+    this.flushing.push(callback);
+    this._commitWhenIdle();
+};
+
+// Commits the outstanding work, turns autocommit back on, then calls callback(err). No 
+// more work can be run from then on.
+GroupCommit.prototype.close = function (callback) {
+    var self = this;
+    this.closed = true;
+    this.flush(function (err) {
+        if (!self.started)
+            return callback && callback(err);
+
+        self.started = false;
+        self.connection.setAutoCommit(true, function (err2) {
+            if (callback)
+                callback(err || err2);
+        });
+    });
+};
+
+GroupCommit.prototype._begin = function () {
+    var self = this;
+    this.committing = true;
+    this.connection.beginTransaction(function (err) {
+        self.committing = false;
+        if (err)
+            return self._failWaiting(err);
+        self.started = true;
+        self._resume();
+    });
+};
+
+GroupCommit.prototype._start = function (work, callback) {
+    var self = this;
+    this.running++;
+
+    if (!this.timer && this.interval > 0)
+        this.timer = setTimeout(function () {
+            self.timer = null;
+            self._commitWhenIdle();
+        }, this.interval);
+
+    work(function (err) {
+        self.running--;
+
+        // Failed work is reported straight away, and not counted towards the transaction.
+        if (err)
+            callback(err);
+        else
+            self.done.push(callback);
+
+        if (self.done.length >= self.statements || self.pendingCommit || (!self.running && self.waiting.length))
+            self._commitWhenIdle();
+    });
+};
+
+// Starts a commit once the work in progress has finished.
+GroupCommit.prototype._commitWhenIdle = function () {
+    if (this.running || this.committing) {
+        this.pendingCommit = true;
+        return;
+    }
+
+    this.pendingCommit = false;
+    if (this.timer) {
+        clearTimeout(this.timer);
+        this.timer = null;
+    }
+
+    var done = this.done, self = this;
+    if (!done.length) {
+        // Nothing to commit, so the flushes are done.
+        var flushing = this.flushing;
+        this.flushing = [];
+        if (flushing.length)
+            process.nextTick(function () { callAll(flushing); });
+        return this._startWaiting();
+    }
+
+    this.done = [];
+    this.committing = true;
+
+    this.connection.commit(function (err) {
+        if (!err)
+            return finish();
+
+        // Leave the connection usable for the next transaction.
+        self.connection.rollback(function () {
+            finish();
+        });
+
+        function finish() {
+            var flushing = self.flushing;
+            self.flushing = [];
+            self.committing = false;
+            callAll(done, err);
+            callAll(flushing, err);
+            self._resume();
+        }
+    });
+};
+
+// Called when a begin or commit has finished: commits again if one became due in the
+// meantime, and otherwise starts the work which was waiting.
+GroupCommit.prototype._resume = function () {
+    if (this.pendingCommit)
+        this._commitWhenIdle();
+    else
+        this._startWaiting();
+};
+
+GroupCommit.prototype._startWaiting = function () {
+    var waiting = this.waiting;
+    this.waiting = [];
+    for (var i = 0; i < waiting.length && !this.committing && !this.pendingCommit && !this._full(); i++) {
+        // A flush commits the work started before it, before any more is started.
+        if (waiting[i].flush) {
+            this.flushing.push(waiting[i].flush);
+            this._commitWhenIdle();
+        } else {
+            this._start(waiting[i].work, waiting[i].callback);
+        }
+    }
+
+    // A unit may have filled up the transaction.
+    for (; i < waiting.length; i++)
+        this.waiting.push(waiting[i]);
+};
+
+// Whether the current transaction has as many units as it should.
+GroupCommit.prototype._full = function () {
+    return this.running + this.done.length >= this.statements;
+};
+
+GroupCommit.prototype._failWaiting = function (err) {
+    var waiting = this.waiting, flushing = this.flushing;
+    this.waiting = [];
+    this.flushing = [];
+    waiting.forEach(function (w) { (w.flush || w.callback)(err); });
+    callAll(flushing, err);
+};
+
+bindings.GroupCommit = GroupCommit;
+
+bindings.Connection.prototype.groupCommit = function (options) {
+    return new GroupCommit(this, options);
+};
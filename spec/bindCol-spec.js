@@ -67,6 +67,89 @@ describe("Column binding", function(){
         });
     });
 
+    it ("should return timestamps as numbers when asked to", function(done) {
+        stmt.timestampsAsNumbers = true;
+
+        var dob = stmt.bindCol(1, eos.SQL_TYPE_DATE);
+        expect(dob.timestampAsNumber).to.be.true;
+
+        stmt.execDirect("select { d '1966-05-15' } as dob", function (err) {
+            if (err)
+                return done(err);
+
+            stmt.fetch(function(err, hasData) {
+                if (err || !hasData)
+                    return done(err || new Error("No results"));
+
+                expect(dob.value).to.equal(new Date(1966, 04, 15).getTime());
+                done();
+            });
+        });
+    });
+
+    it ("should keep bound values until the callback returns when fetches are queued", function(done) {
+        var id = stmt.bindCol(1, eos.SQL_INTEGER), seen = [];
+
+        stmt.execDirect("select 1 as id union all select 2", function (err) {
+            if (err)
+                return done(err);
+
+            // The second fetch is queued behind the first, and must not overwrite the 
+            // bound value while the first callback reads it.
+            stmt.fetch(function (err, hasData) {
+                if (err || !hasData)
+                    return done(err || new Error("No results"));
+                seen.push(id.value);
+            });
+
+            stmt.fetch(function (err, hasData) {
+                if (err || !hasData)
+                    return done(err || new Error("Expected a second row"));
+                seen.push(id.value);
+
+                expect(seen).to.deep.equal([1, 2]);
+                done();
+            });
+        });
+    });
+
+    it ("should fetch blocks of rows", function(done) {
+        var sql = "select 1 as id, 'Fred' as name union all select null, 'Janet' union all select 3, 'Alex'";
+
+        stmt.bindBlock([eos.SQL_INTEGER, { type: eos.SQL_WVARCHAR, length: 60 }], 2);
+
+        stmt.execDirect(sql, function (err) {
+            if (err)
+                return done(err);
+
+            stmt.fetchBlock(function (err, rowsFetched, values, nulls) {
+                if (err)
+                    return done(err);
+
+                expect(rowsFetched).to.equal(2);
+                expect(values[0][0]).to.equal(1);
+                expect(isNaN(values[0][1])).to.be.true;
+                expect(nulls[0][0]).to.equal(2);
+                expect(values[1]).to.deep.equal(["Fred", "Janet"]);
+                expect(nulls[1]).to.be.null;
+
+                stmt.fetchBlock(function (err, rowsFetched, values) {
+                    if (err)
+                        return done(err);
+
+                    expect(rowsFetched).to.equal(1);
+                    expect(values[1]).to.deep.equal(["Alex"]);
+
+                    stmt.fetchBlock(function (err, rowsFetched) {
+                        expect(rowsFetched).to.equal(0);
+                        stmt.unbindBlock();
+                        done(err);
+                    });
+                });
+            });
+        });
+    });
+
     afterEach(function(){
         stmt.free();
         conn.disconnect(conn.free.bind(conn));
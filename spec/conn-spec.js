@@ -33,6 +33,39 @@ describe("A newly created connection", function () {
         common.conn(done);
     });
 
+    it("should allocate and free handles on the worker threads when given callbacks", function (done) {
+        env.newConnection(function (err, conn) {
+            if (err)
+                return done(err);
+
+            conn.driverConnect(common.settings.connectionString, function (err) {
+                if (err)
+                    return done(err);
+
+                conn.newStatement(function (err, stmt) {
+                    if (err)
+                        return done(err);
+
+                    stmt.free(function (err) {
+                        if (err)
+                            return done(err);
+
+                        conn.disconnect(function (err) {
+                            if (err)
+                                return done(err);
+                            conn.free(done);
+                        });
+                    });
+
+                    // Nothing can be queued behind the free.
+                    expect(function () {
+                        stmt.execDirect("select 1 as x", function () {});
+                    }).to.throw(/being freed/);
+                });
+            });
+        });
+    });
+
     it("should connect using SQLConnect using 1 parameter", function (done) {
         var c = env.newConnection();
         c.connect(common.settings.dsn, done);
@@ -83,6 +116,71 @@ describe("For a connected connection", function () {
         });
     });
 
+    describe("transactions", function () {
+        it("should turn autocommit off and on", function (done) {
+            expect(conn.autoCommit).to.be.true;
+
+            conn.beginTransaction(function (err) {
+                if (err)
+                    return done(err);
+
+                expect(conn.autoCommit).to.be.false;
+                conn.newStatement().execDirect("select 1 as x", function (err) {
+                    if (err)
+                        return done(err);
+
+                    conn.commit(function (err) {
+                        if (err)
+                            return done(err);
+
+                        conn.rollback(function (err) {
+                            if (err)
+                                return done(err);
+
+                            conn.setAutoCommit(true, function (err) {
+                                expect(conn.autoCommit).to.be.true;
+                                done(err);
+                            });
+                        });
+                    });
+                });
+            });
+        });
+
+        it("should group statements into commits", function (done) {
+            var group = conn.groupCommit({ statements: 2, interval: 0 }),
+                committed = 0, commits = 0,
+                commit = conn.commit;
+
+            conn.commit = function (callback) {
+                commits++;
+                return commit.call(conn, callback);
+            };
+
+            for (var i = 0; i < 5; i++) {
+                group.run(function (callback) {
+                    conn.newStatement().execDirect("select 1 as x", callback);
+                }, function (err) {
+                    if (err)
+                        return done(err);
+                    committed++;
+                });
+            }
+
+            group.close(function (err) {
+                if (err)
+                    return done(err);
+
+                expect(committed).to.equal(5);
+                expect(commits).to.equal(3);
+                expect(conn.autoCommit).to.be.true;
+                done();
+            });
+
+            expect(function () { group.run(function (callback) { callback(); }, function () {}); }).to.throw(/closed/);
+        });
+    });
+
     afterEach(function () {
         conn.disconnect(conn.free.bind(conn));
     });
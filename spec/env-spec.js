@@ -11,6 +11,231 @@ describe("Environment", function () {
         new eos.Environment().free();
     });
 
+    describe("worker threads", function () {
+        it("should default to 16", function () {
+            expect(new eos.Environment().workerThreads).to.equal(16);
+        });
+
+        it("should be configurable", function () {
+            expect(new eos.Environment({ workerThreads: 2 }).workerThreads).to.equal(2);
+        });
+
+        it("should reject invalid values", function () {
+            expect(function () { new eos.Environment({ workerThreads: 0 }) }).to.throw(RangeError);
+            expect(function () { new eos.Environment({ workerThreads: "lots" }) }).to.throw(RangeError);
+            expect(function () { new eos.Environment(4) }).to.throw(TypeError);
+        });
+
+        it("should allow callbacks to be coalesced", function (done) {
+            var env = new eos.Environment({ coalesceCallbacks: true, workerThreads: 4 }),
+                remaining = 4;
+
+            this.timeout(10000);
+            expect(env.coalesceCallbacks).to.be.true;
+
+            for (var i = 0; i < 4; i++) {
+                env.newConnection().driverConnect(common.settings.connectionString, function (err) {
+                    if (err)
+                        return done(err);
+                    process.nextTick(function () {
+                        if (--remaining > 0)
+                            return;
+
+                        var batches = env.poolStats().callbackBatches;
+                        expect(batches.count).to.be.at.least(1);
+                        expect(batches.largest).to.be.at.least(2);
+                        done();
+                    });
+                });
+            }
+
+            // Keep the event loop busy until the connections have been made, so that their
+            // completions are all waiting when it next looks.
+            var until = Date.now() + 3000;
+            while (Date.now() < until)
+                ;
+        });
+
+        it("should run operations on more connections than threads", function (done) {
+            var env = new eos.Environment({ workerThreads: 1 }),
+                remaining = 3;
+
+            for (var i = 0; i < 3; i++) {
+                env.newConnection().driverConnect(common.settings.connectionString, function (err) {
+                    if (err)
+                        return done(err);
+                    if (--remaining === 0)
+                        done();
+                });
+            }
+        });
+
+        it("should pass priorities on to connections and statements", function (done) {
+            var env = new eos.Environment({ workerThreads: 1 });
+
+            expect(env.priority).to.equal("interactive");
+            expect(function () { env.priority = "urgent"; }).to.throw(/priority/);
+            env.priority = "batch";
+
+            var conn = env.newConnection();
+            expect(conn.priority).to.equal("batch");
+
+            conn.driverConnect(common.settings.connectionString, function (err) {
+                if (err)
+                    return done(err);
+
+                var stats = env.poolStats();
+                expect(stats.threads).to.equal(1);
+                expect(stats.batch.started).to.equal(1);
+                expect(stats.batch.queued).to.equal(0);
+                expect(stats.interactive.started).to.equal(0);
+                var stmt = conn.newStatement();
+                expect(stmt.priority).to.equal("batch");
+                expect(function () { stmt.priority = "interactive"; }).to.throw(/connection's priority/);
+
+                stmt.execDirect("select 1 as x", function (err) {
+                    if (err)
+                        return done(err);
+
+                    conn.priority = "interactive";
+                    expect(stmt.priority).to.equal("interactive");
+                    done();
+                });
+
+                expect(function () { conn.priority = "interactive"; }).to.throw(/queued/);
+            });
+        });
+
+        it("should run statements with asynchronous polling where supported", function (done) {
+            var env = new eos.Environment({ asyncPolling: true }),
+                conn = env.newConnection();
+
+            expect(env.asyncPolling).to.be.true;
+
+            conn.driverConnect(common.settings.connectionString, function (err) {
+                if (err)
+                    return done(err);
+
+                var stmt = conn.newStatement();
+                expect(stmt.asyncPolling).to.be.a("boolean");
+
+                stmt.execDirect("select 123 as foo", function (err) {
+                    if (err)
+                        return done(err);
+                    stmt.fetch(function (err, hasData) {
+                        if (err)
+                            return done(err);
+                        expect(hasData).to.be.true;
+                        done();
+                    });
+                });
+            });
+        });
+
+        it("should complete polled statements on the polling thread", function (done) {
+            var env = new eos.Environment({ asyncPolling: true }),
+                conn = env.newConnection();
+
+            conn.driverConnect(common.settings.connectionString, function (err) {
+                if (err)
+                    return done(err);
+
+                // Only drivers which report SQL_AM_STATEMENT are polled.
+                var stmt = conn.newStatement();
+                if (!stmt.asyncPolling)
+                    return done();
+
+                var before = env.poolStats().polled;
+
+                stmt.execDirect("waitfor delay '00:00:00.2'; select 123 as foo", function (err) {
+                    if (err)
+                        return done(err);
+
+                    var after = env.poolStats().polled;
+                    expect(after.completed).to.equal(before.completed + 1);
+                    expect(after.polls).to.be.above(before.polls + 1);
+                    done();
+                });
+            });
+        });
+    });
+
+    describe("connection pooling", function () {
+        it("should reject invalid options", function () {
+            expect(function () { new eos.Environment({ connectionPooling: "process" }) }).to.throw(RangeError);
+            expect(function () { new eos.Environment({ connectionPoolMatch: "loose" }) }).to.throw(RangeError);
+            expect(function () { common.env.connectionPoolMatch = "loose"; }).to.throw(RangeError);
+        });
+
+        it("should count reused connections", function (done) {
+            var env = new eos.Environment({ connectionPooling: "environment", connectionPoolMatch: "relaxed" });
+
+            expect(env.connectionPooling).to.equal("environment");
+            expect(env.connectionPoolMatch).to.equal("relaxed");
+
+            var conn = env.newConnection();
+            conn.driverConnect(common.settings.connectionString, function (err) {
+                if (err)
+                    return done(err);
+
+                conn.disconnect(function (err) {
+                    if (err)
+                        return done(err);
+
+                    conn.driverConnect(common.settings.connectionString, function (err) {
+                        if (err)
+                            return done(err);
+
+                        // Whether the second connection is reused depends on the driver
+                        // manager's pooling (unixODBC needs Pooling=Yes), and the split is an
+                        // estimate, so only the total is certain.
+                        var stats = env.connectionStats();
+                        expect(stats.fresh).to.be.at.least(1);
+                        expect(stats.fresh + stats.reused).to.equal(2);
+                        conn.disconnect(done);
+                    });
+                });
+            });
+        });
+    });
+
+    describe("Environment.openMany", function () {
+        it("should open connections in parallel", function (done) {
+            var env = new eos.Environment({ workerThreads: 4 });
+
+            env.openMany(common.settings.connectionString, 6, 3, function (err, connections, errors) {
+                if (err)
+                    return done(err);
+
+                expect(errors).to.be.empty;
+                expect(connections).to.have.length(6);
+                connections.forEach(function (conn) {
+                    expect(conn).to.be.an.instanceof(eos.Connection);
+                });
+                expect(env.poolStats().threads).to.be.above(1);
+                done();
+            });
+
+            // The connects use the environment handle on the worker threads.
+            expect(function () { env.free(); }).to.throw(/in progress/);
+        });
+
+        it("should report each failure", function (done) {
+            common.env.openMany("Driver={Not a real driver}", 2, function (err, connections, errors) {
+                expect(err).to.be.an.instanceof(eos.OdbcError);
+                expect(connections).to.be.empty;
+                expect(errors).to.have.length(2);
+                done();
+            });
+        });
+
+        it("should reject invalid arguments", function () {
+            expect(function () { common.env.openMany(common.settings.connectionString, 0, function () {}); }).to.throw(RangeError);
+            expect(function () { common.env.openMany(common.settings.connectionString, 2, 0, function () {}); }).to.throw(RangeError);
+            expect(function () { common.env.openMany(common.settings.connectionString, 2); }).to.throw();
+        });
+    });
+
     describe("Environment.drivers", function () {
         it("should return an array", function () {
             var drivers = common.env.drivers();
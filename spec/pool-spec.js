@@ -0,0 +1,83 @@
+var eos = require("../"),
+    common = require("./common"),
+    expect = common.expect,
+    env = common.env;
+
+describe("A connection pool", function () {
+    var pool;
+
+    afterEach(function () {
+        if (pool)
+            pool.close();
+        pool = null;
+    });
+
+    it("should reject invalid options", function () {
+        expect(function () { new eos.Pool(env, common.settings.connectionString, { max: 0 }); }).to.throw(RangeError);
+        expect(function () { new eos.Pool(env, common.settings.connectionString, { min: 2, max: 1 }); }).to.throw(RangeError);
+        expect(function () { new eos.Pool({}, common.settings.connectionString); }).to.throw(TypeError);
+    });
+
+    it("should reuse released connections", function (done) {
+        pool = new eos.Pool(env, common.settings.connectionString, { max: 1 });
+
+        pool.acquire(function (err, first) {
+            if (err)
+                return done(err);
+
+            expect(pool.stats().busy).to.equal(1);
+
+            pool.acquire(function (err, second) {
+                if (err)
+                    return done(err);
+
+                expect(second).to.equal(first);
+
+                var stats = pool.stats();
+                expect(stats.created).to.equal(1);
+                expect(stats.size).to.equal(1);
+                pool.release(second);
+                done();
+            });
+
+            expect(pool.stats().waiting).to.equal(1);
+            pool.release(first);
+        });
+    });
+
+    it("should time out when no connection is released", function (done) {
+        pool = new eos.Pool(env, common.settings.connectionString, { max: 1, acquireTimeout: 200 });
+
+        pool.acquire(function (err, conn) {
+            if (err)
+                return done(err);
+
+            pool.acquire(function (err) {
+                expect(err).to.be.an.instanceof(eos.OdbcError);
+                expect(err.state).to.equal("HYT00");
+                expect(pool.stats().timeouts).to.equal(1);
+                pool.destroy(conn);
+                done();
+            });
+        });
+    });
+
+    it("should free the statements of released connections", function (done) {
+        pool = new eos.Pool(env, common.settings.connectionString, { max: 1 });
+
+        pool.acquire(function (err, conn) {
+            if (err)
+                return done(err);
+
+            var stmt = conn.newStatement();
+            stmt.execDirect("select 1 as x", function (err) {
+                if (err)
+                    return done(err);
+
+                pool.release(conn);
+                expect(function () { stmt.execDirect("select 2 as x", function () {}); }).to.throw(/freed/);
+                done();
+            });
+        });
+    });
+});
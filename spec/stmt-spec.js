@@ -34,6 +34,75 @@ describe("A newly created statement", function () {
         });
     });
 
+    it("should queue operations started before the previous one completes", function (done) {
+        var order = [];
+
+        stmt.execDirect("select 123 as foo", function (err) {
+            if (err)
+                return done(err);
+            order.push("execDirect");
+        });
+
+        stmt.fetch(function (err, hasData) {
+            if (err)
+                return done(err);
+            expect(hasData).to.be.true;
+            order.push("fetch");
+        });
+
+        stmt.getData(1, eos.SQL_INTEGER, null, false, function (err, result) {
+            if (err)
+                return done(err);
+            expect(result).to.equal(123);
+            expect(order).to.deep.equal(["execDirect", "fetch"]);
+            done();
+        });
+    });
+
+    it("should close the cursor after queued operations when given a callback", function (done) {
+        stmt.execDirect("select 123 as foo", function (err) {
+            if (err)
+                return done(err);
+        });
+
+        stmt.closeCursor(true, function (err) {
+            if (err)
+                return done(err);
+
+            stmt.closeCursor(true, function (err) {
+                done(err ? null : "Expected an error closing a closed cursor");
+            });
+        });
+    });
+
+    it("should not be freed while operations are queued", function (done) {
+        stmt.execDirect("select 123 as foo", done);
+        expect(function () { stmt.free(); }).to.throw(/in progress/);
+    });
+
+    if (typeof Promise === "function") {
+        it("should return promises when the callback is omitted", function (done) {
+            stmt.execDirect("select 123 as foo").then(function () {
+                return stmt.fetch();
+            }).then(function (hasData) {
+                expect(hasData).to.be.true;
+                return stmt.getData(1, eos.SQL_INTEGER, null, false);
+            }).then(function (data) {
+                expect(data[0]).to.equal(123);
+                done();
+            }).catch(done);
+        });
+
+        it("should reject the promise when the operation fails", function (done) {
+            stmt.execute().then(function () {
+                done("Expected error");
+            }, function (err) {
+                expect(err).to.be.an.instanceof(eos.OdbcError);
+                done();
+            });
+        });
+    }
+
     function testInputParam(val, kind, type, digits, cmp, gdType) {
         if (!cmp)
             cmp = function (x, y) { return x === y; };
@@ -347,6 +416,407 @@ describe("A prepared statement", function () {
     });
 });
 
+describe("The statement cache", function () {
+    var conn;
+
+    beforeEach(function (done) {
+        common.conn(function (err, c) {
+            if (err)
+                return done(err);
+
+            conn = c;
+            done();
+        });
+    });
+
+    it("should hand out released statements again", function (done) {
+        var sql = "select 123 as foo";
+
+        conn.prepareCached(sql, function (err, first) {
+            if (err)
+                return done(err);
+
+            first.execute(function (err) {
+                if (err)
+                    return done(err);
+
+                // The cursor is left open, for prepareCached to close.
+                first.release();
+
+                conn.prepareCached(sql, function (err, second) {
+                    if (err)
+                        return done(err);
+
+                    expect(second).to.equal(first);
+                    expect(conn.statementCacheStats()).to.include({ hits: 1, misses: 1, size: 0 });
+                    second.execute(done);
+                });
+            });
+        });
+    });
+
+    it("should evict the least recently released statement", function (done) {
+        conn.statementCacheSize = 1;
+
+        conn.prepareCached("select 1 as x", function (err, a) {
+            if (err)
+                return done(err);
+
+            conn.prepareCached("select 2 as x", function (err, b) {
+                if (err)
+                    return done(err);
+
+                a.release();
+                b.release();
+
+                var stats = conn.statementCacheStats();
+                expect(stats.size).to.equal(1);
+                expect(stats.evictions).to.equal(1);
+                done();
+            });
+        });
+    });
+
+    it("should prepare SQL executed autoPrepare times", function (done) {
+        var stmt = conn.newStatement(), remaining = 4;
+
+        conn.autoPrepare = 2;
+
+        (function next(err) {
+            if (err)
+                return done(err);
+
+            if (remaining-- === 0) {
+                expect(conn.statementCacheStats()).to.include({ autoPrepared: 1, hits: 2 });
+                return done();
+            }
+
+            stmt.closeCursor();
+            stmt.execDirect("select 123 as foo", next);
+        })();
+    });
+
+    it("should reuse auto-prepared SQL on new statements through the cache", function (done) {
+        var remaining = 3;
+
+        conn.autoPrepare = 1;
+
+        (function next() {
+            if (remaining-- === 0) {
+                expect(conn.statementCacheStats()).to.include({ size: 1, autoPrepared: 1, hits: 2 });
+                return done();
+            }
+
+            var stmt = conn.newStatement();
+            stmt.execDirect("select 123 as foo", function (err) {
+                if (err)
+                    return done(err);
+
+                stmt.free();
+                next();
+            });
+        })();
+    });
+});
+
+describe("Batch execution", function () {
+    var conn, stmt;
+
+    beforeEach(function (done) {
+        common.conn(function (err, c) {
+            if (err)
+                return done(err);
+
+            conn = c;
+            stmt = c.newStatement();
+            stmt.execDirect("create table #batch (id int, name nvarchar(20))", function (err) {
+                if (err)
+                    return done(err);
+
+                stmt.closeCursor();
+                stmt.prepare("insert into #batch (id, name) values (?, ?)", done);
+            });
+        });
+    });
+
+    it("should insert every row and report a status for each", function (done) {
+        var rows = [[1, "Fred"], [2, null], [3, "Alex"]];
+
+        stmt.executeBatch(rows, [eos.SQL_INTEGER, eos.SQL_WVARCHAR], function (err, statuses, processed) {
+            if (err)
+                return done(err);
+
+            expect(processed).to.equal(3);
+            expect(statuses).to.deep.equal([eos.SQL_PARAM_SUCCESS, eos.SQL_PARAM_SUCCESS, eos.SQL_PARAM_SUCCESS]);
+            done();
+        });
+    });
+
+    it("should infer a type from every value of a column", function (done) {
+        var rows = [[1, null], [2.5, "Janet"], [3, "Alex"]];
+
+        stmt.executeBatch(rows, function (err, statuses, processed) {
+            if (err)
+                return done(err);
+
+            expect(processed).to.equal(3);
+            done();
+        });
+    });
+
+    it("should reject columns with values of different types", function () {
+        expect(function () {
+            stmt.executeBatch([[1, "Fred"], ["two", "Janet"]], function () {});
+        }).to.throw(TypeError, /parameter 1/);
+    });
+
+    it("should bind described parameters without types", function (done) {
+        stmt.prepare("insert into #batch (id, name) values (?, ?)", true, function (err) {
+            if (err)
+                return done(err);
+
+            var descs = stmt.parameterDescriptions;
+            expect(descs.length).to.equal(2);
+            expect(descs[0].type).to.equal(eos.SQL_INTEGER);
+            expect(descs[1].type).to.equal(eos.SQL_WVARCHAR);
+            expect(descs[1].columnSize).to.equal(20);
+
+            stmt.bindParameter(1, eos.SQL_PARAM_INPUT, null, null, null, 4);
+            stmt.bindParameter(2, eos.SQL_PARAM_INPUT, null, null, null, "Anne");
+            stmt.execute(done);
+        });
+    });
+
+    it("should insert rows with a parameter block", function (done) {
+        var block = stmt.bindParameters([eos.SQL_INTEGER, { type: eos.SQL_WVARCHAR, columnSize: 20 }]);
+        expect(block.length).to.equal(2);
+
+        block.setValues([1, "Fred"]);
+        stmt.execute(function (err) {
+            if (err)
+                return done(err);
+
+            block.setValues([2, null]);
+            stmt.execute(done);
+        });
+    });
+
+    it("should refuse new block values while the statement is executing", function (done) {
+        var block = stmt.bindParameters([eos.SQL_INTEGER, { type: eos.SQL_WVARCHAR, columnSize: 20 }]);
+
+        block.setValues([1, "Fred"]);
+        stmt.execute(done);
+
+        expect(function () { block.setValues([2, "Janet"]); }).to.throw(/busy/);
+    });
+
+    it("should refuse block values once one of its parameters is rebound", function () {
+        var block = stmt.bindParameters([eos.SQL_INTEGER, { type: eos.SQL_WVARCHAR, columnSize: 20 }]);
+
+        stmt.bindParameter(1, eos.SQL_PARAM_INPUT, eos.SQL_INTEGER, 0, 0, 3);
+        expect(function () { block.setValues([2, "Janet"]); }).to.throw(/no longer bound/);
+    });
+
+    it("should bind typed arrays as columns of parameters", function (done) {
+        var ids = new Int32Array([1, 2, 3]),
+            nulls = new Buffer([2]); // The second id is null
+
+        stmt.executeColumns([
+            { values: ids, nulls: nulls },
+            { type: eos.SQL_WVARCHAR, values: ["Fred", "Janet", "Alex"] }
+        ], function (err, statuses, processed) {
+            if (err)
+                return done(err);
+
+            expect(processed).to.equal(3);
+            expect(statuses).to.deep.equal([eos.SQL_PARAM_SUCCESS, eos.SQL_PARAM_SUCCESS, eos.SQL_PARAM_SUCCESS]);
+            done();
+        });
+    });
+
+    afterEach(function () {
+        stmt.free();
+        conn.disconnect(conn.free.bind(conn));
+    });
+});
+
+describe("Streaming data-at-execution parameters", function () {
+    var conn, stmt;
+
+    beforeEach(function (done) {
+        common.stmt(function (err, s, c) {
+            if (err)
+                return done(err);
+
+            conn = c;
+            stmt = s;
+            done();
+        });
+    });
+
+    it("should send every chunk of a Readable", function (done) {
+        var param = stmt.bindParameter(1, eos.SQL_PARAM_INPUT, eos.SQL_LONGVARBINARY, 0, 0),
+            readable = new (require("stream").PassThrough)(),
+            expected = new Buffer(100000);
+
+        for (var i = 0; i < expected.length; i++)
+            expected[i] = i % 251;
+
+        stmt.execDirect("select datalength(?) as x", function (err, needData) {
+            if (err)
+                return done(err);
+
+            expect(needData).to.be.true;
+
+            stmt.paramData(function (err, dae) {
+                if (err)
+                    return done(err);
+
+                expect(dae.index).to.equal(param.index);
+
+                stmt.putStream(dae, readable, function (err, next, needData) {
+                    if (err)
+                        return done(err);
+
+                    expect(needData).to.be.false;
+
+                    stmt.fetch(function (err, hasData) {
+                        if (err || !hasData)
+                            return done(err || new Error("No results"));
+
+                        stmt.getData(1, eos.SQL_INTEGER, null, false, function (err, result) {
+                            expect(result).to.equal(expected.length);
+                            done(err);
+                        });
+                    });
+                });
+
+                readable.write(expected.slice(0, 60000));
+                readable.end(expected.slice(60000));
+            });
+        });
+    });
+
+    it("should wait for ondrain when more than the high-water mark is written", function (done) {
+        var param = stmt.bindParameter(1, eos.SQL_PARAM_INPUT, eos.SQL_LONGVARBINARY, 0, 0),
+            chunk = new Buffer(64 * 1024),
+            total = 1024 * 1024,
+            written = 0,
+            drains = 0;
+
+        chunk.fill(7);
+
+        stmt.execDirect("select datalength(?) as x", function (err, needData) {
+            if (err)
+                return done(err);
+
+            stmt.paramData(function (err, dae) {
+                if (err)
+                    return done(err);
+
+                var sink = stmt.putDataStream(dae, function (err, next, needData) {
+                    if (err)
+                        return done(err);
+
+                    expect(needData).to.be.false;
+                    expect(drains).to.be.above(0);
+
+                    stmt.fetch(function (err, hasData) {
+                        if (err || !hasData)
+                            return done(err || new Error("No results"));
+
+                        stmt.getData(1, eos.SQL_INTEGER, null, false, function (err, result) {
+                            expect(result).to.equal(total);
+                            done(err);
+                        });
+                    });
+                });
+
+                sink.ondrain = function () {
+                    drains++;
+                    // Written from a timer, so that the operation has run out of data 
+                    // and is waiting for more.
+                    setTimeout(write, 10);
+                };
+
+                function write() {
+                    while (written < total) {
+                        written += chunk.length;
+                        if (!sink.write(chunk))
+                            return;
+                    }
+
+                    sink.end();
+                }
+
+                write();
+            });
+        });
+    });
+
+    it("should require a callback for putDataStream", function () {
+        expect(function () { stmt.putDataStream(1, undefined); }).to.throw(TypeError);
+    });
+
+    afterEach(function () {
+        stmt.free();
+        conn.disconnect(conn.free.bind(conn));
+    });
+});
+
+describe("A bound string parameter", function () {
+    var conn, stmt;
+
+    beforeEach(function (done) {
+        common.stmt(function (err, s, c) {
+            if (err)
+                return done(err);
+
+            conn = c;
+            stmt = s;
+            stmt.prepare("select ? as x", done);
+        });
+    });
+
+    it("should grow its buffer when given a longer value", function (done) {
+        var param = stmt.bindParameter(1, eos.SQL_PARAM_INPUT, eos.SQL_WVARCHAR, 0, 0, "short"),
+            value = new Array(1001).join("long");
+
+        param.value = value;
+
+        stmt.execute(function (err) {
+            if (err)
+                return done(err);
+
+            stmt.fetch(function (err, hasData) {
+                if (err || !hasData)
+                    return done(err || new Error("No results"));
+
+                stmt.getData(1, eos.SQL_WVARCHAR, new Buffer(16384), false, function (err, result) {
+                    expect(result).to.equal(value);
+                    done(err);
+                });
+            });
+        });
+    });
+
+    it("should refuse a new value while the statement is executing", function (done) {
+        var param = stmt.bindParameter(1, eos.SQL_PARAM_INPUT, eos.SQL_WVARCHAR, 0, 0, "short");
+
+        stmt.execute(done);
+
+        expect(function () {
+            param.value = new Array(1001).join("long");
+        }).to.throw(/busy/);
+        expect(param.value).to.equal("short");
+    });
+
+    afterEach(function () {
+        stmt.free();
+        conn.disconnect(conn.free.bind(conn));
+    });
+});
+
 describe("Cancelling statement operations", function () {
     var conn, stmt;
 
@@ -378,6 +848,46 @@ describe("Cancelling statement operations", function () {
         }, 500);
     });
 
+    it("should cancel operations which run for longer than the timeout", function (done) {
+        expect(stmt.timeout).to.equal(0);
+        expect(function () { stmt.timeout = -1; }).to.throw(RangeError);
+
+        stmt.timeout = 500;
+        expect(stmt.timeout).to.equal(500);
+
+        // The driver's own timeout (SQL_ATTR_QUERY_TIMEOUT, rounded up to 1 second) may fire 
+        // first, with HYT00, but anything else means neither worked.
+        stmt.execute(function (err) {
+            if (!err)
+                return done(new Error("Expected HY008 (operation cancelled) or HYT00 (timeout expired)"));
+
+            expect(["HY008", "HYT00"]).to.include(err.state);
+            done();
+        });
+    });
+
+    it("should free a statement with a timeout in the background", function (done) {
+        stmt.timeout = 1;
+        stmt.free(function (err) {
+            if (err)
+                return done(err);
+
+            // The free was not cancelled by the watchdog.
+            expect(function () { stmt.execute(function () {}); }).to.throw(/freed/);
+            done();
+        });
+    });
+
+    it("should not free a statement while cancel(callback) is running", function (done) {
+        stmt.cancel(function (err) {
+            // The statement is freed once nothing uses it, after this test.
+            done(err);
+        });
+
+        expect(function () { stmt.free(); }).to.throw(/in progress/);
+        expect(function () { stmt.free(function () {}); }).to.throw(/in progress/);
+    });
+
     afterEach(function () {
         stmt.free();
         conn.disconnect(conn.free.bind(conn));
@@ -86,6 +86,39 @@ namespace Eos {
             }
         }
 
+        SQLLEN GetValueLength(SQLSMALLINT cType, Handle<Value> jsValue) {
+            switch (cType) {
+            case SQL_C_CHAR:
+                return jsValue->ToString()->Utf8Length();
+
+            case SQL_C_WCHAR:
+                return jsValue->ToString()->Length() * sizeof(uint16_t);
+
+            case SQL_C_BINARY:
+                if (JSBuffer::HasInstance(jsValue)) {
+                    SQLPOINTER data;
+                    SQLLEN length;
+                    if (!JSBuffer::Unwrap(jsValue.As<Object>(), data, length))
+                        return length;
+                }
+                return -1;
+
+            default:
+                return -1;
+            }
+        }
+
+        SQLLEN WriteString(SQLSMALLINT cType, Handle<String> str, SQLPOINTER buffer, SQLLEN length) {
+            assert(length <= INT_MAX);
+
+            if (cType == SQL_C_CHAR)
+                return str->WriteUtf8(reinterpret_cast<char*>(buffer), static_cast<int>(length), nullptr, String::NO_NULL_TERMINATION);
+
+            assert(cType == SQL_C_WCHAR);
+            auto chars = str->Write(reinterpret_cast<uint16_t*>(buffer), 0, static_cast<int>(length / sizeof(uint16_t)), String::NO_NULL_TERMINATION);
+            return chars * sizeof(uint16_t);
+        }
+
         bool AllocateBoundInputParameter(SQLSMALLINT cType, Handle<Value> jsValue, SQLPOINTER& buffer, SQLLEN& length, Handle<Object>& handle) {
             switch (cType) {
             case SQL_C_SLONG:
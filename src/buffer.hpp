@@ -24,6 +24,19 @@ namespace Eos {
             Handle<Value> jsValue,
             SQLPOINTER buffer, SQLLEN length);
 
+        // Returns the number of bytes needed to hold jsValue as a SQL_C_CHAR (UTF-8),
+        // SQL_C_WCHAR (UTF-16) or SQL_C_BINARY value, or -1 if it cannot be converted.
+        SQLLEN GetValueLength(
+            SQLSMALLINT cType,
+            Handle<Value> jsValue);
+
+        // Encodes str straight into buffer without a null terminator, as UTF-8 for 
+        // SQL_C_CHAR or UTF-16 for SQL_C_WCHAR. Returns the number of bytes written.
+        SQLLEN WriteString(
+            SQLSMALLINT cType,
+            Handle<String> str,
+            SQLPOINTER buffer, SQLLEN length);
+
         bool AllocateBoundInputParameter(
             SQLSMALLINT cType,
             Handle<Value> jsValue,
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+
+namespace Eos {
+    // Something which finishes on another thread, and must then be called back on the main
+    // thread: an operation run by the worker pool or the polling thread, or a handle whose
+    // asynchronous notification has been signalled.
+    struct Completion {
+        Completion() : nextCompletion_(nullptr) { }
+
+        // Called on the main thread.
+        virtual void Completed() = 0;
+
+    private:
+        friend struct CompletionQueue;
+        Completion* nextCompletion_;
+    };
+
+    // A lock-free queue of completions, pushed by any number of threads and drained by the
+    // main thread. Producers push onto an intrusive stack with a single compare-and-swap; the
+    // consumer takes the whole stack with one exchange and reverses it, so each wakeup drains
+    // everything which has completed since the last one, in order, without taking a lock.
+    struct CompletionQueue {
+        CompletionQueue() : head_(nullptr) { }
+
+        ~CompletionQueue() {
+            assert(IsEmpty());
+        }
+
+        // Any thread. Returns true if the queue was empty, in which case the consumer needs
+        // waking; otherwise a wakeup is already due.
+        bool Push(Completion* completion) {
+            auto head = head_.load(std::memory_order_relaxed);
+            do {
+                completion->nextCompletion_ = head;
+            } while (!head_.compare_exchange_weak(head, completion, std::memory_order_release, std::memory_order_relaxed));
+
+            return head == nullptr;
+        }
+
+        // Consumer only. Takes every completion from the queue, oldest first, as a list to
+        // be walked with Next(). Read the next completion before calling Completed() on the
+        // current one, since it may be queued again from inside its callback.
+        Completion* PopAll() {
+            auto list = head_.exchange(nullptr, std::memory_order_acquire);
+
+            Completion* ordered = nullptr;
+            while (list) {
+                auto next = list->nextCompletion_;
+                list->nextCompletion_ = ordered;
+                ordered = list;
+                list = next;
+            }
+
+            return ordered;
+        }
+
+        static Completion* Next(Completion* completion) {
+            return completion->nextCompletion_;
+        }
+
+        bool IsEmpty() const {
+            return head_.load(std::memory_order_relaxed) == nullptr;
+        }
+
+    private:
+        CompletionQueue(const CompletionQueue&); // = delete
+
+        std::atomic<Completion*> head_;
+    };
+}
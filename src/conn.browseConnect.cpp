@@ -45,6 +45,9 @@ namespace Eos {
 
             EOS_DEBUG(L"Final Result: %hi\n", ret);
 
+            if (ret != SQL_NEED_DATA)
+                Owner()->Connected();
+
             Handle<Value> argv[] = { 
                 NanUndefined(),
                 ret == SQL_NEED_DATA ? NanTrue() : NanFalse(),
@@ -67,8 +70,8 @@ namespace Eos {
 NAN_METHOD(Connection::BrowseConnect) {
     EOS_DEBUG_METHOD();
 
-    if (args.Length() < 2)
-        return NanThrowError("Connection::BrowseConnect() requires 2 arguments");
+    if (args.Length() < 1)
+        return NanThrowError("Connection::BrowseConnect() requires a connection string");
 
     Handle<Value> argv[] = { NanObjectWrapHandle(this), args[0], args[1] };
     return Begin<BrowseConnectOperation>(argv);
@@ -95,6 +95,16 @@ namespace Eos {
                 password_, passwordLength_);
         }
 
+        void CallbackOverride(SQLRETURN ret) {
+            EOS_DEBUG_METHOD();
+
+            if (!SQL_SUCCEEDED(ret))
+                return CallbackErrorOverride(ret);
+
+            Owner()->Connected();
+            MakeCallback(0, nullptr);
+        }
+
         // TODO When do these get deleted?
 
     protected:
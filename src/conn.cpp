@@ -1,6 +1,8 @@
 #include "conn.hpp"
 #include "stmt.hpp"
 
+#include <algorithm>
+
 using namespace Eos;
 
 Persistent<FunctionTemplate> Connection::constructor_;
@@ -17,17 +19,205 @@ void Connection::Init(Handle<Object> exports) {
     EOS_SET_METHOD(Constructor(), "newStatement", Connection, NewStatement, sig0);
     EOS_SET_METHOD(Constructor(), "nativeSql", Connection, NativeSql, sig0);
     EOS_SET_METHOD(Constructor(), "disconnect", Connection, Disconnect, sig0);
+    EOS_SET_METHOD(Constructor(), "reset", Connection, Reset, sig0);
+    EOS_SET_METHOD(Constructor(), "prepareCached", Connection, PrepareCached, sig0);
+    EOS_SET_METHOD(Constructor(), "statementCacheStats", Connection, StatementCacheStats, sig0);
+    EOS_SET_ACCESSOR(Constructor(), "statementCacheSize", Connection, GetStatementCacheSize, SetStatementCacheSize);
+    EOS_SET_ACCESSOR(Constructor(), "autoPrepare", Connection, GetAutoPrepare, SetAutoPrepare);
+    EOS_SET_METHOD(Constructor(), "setAutoCommit", Connection, SetAutoCommit, sig0);
+    EOS_SET_METHOD(Constructor(), "beginTransaction", Connection, BeginTransaction, sig0);
+    EOS_SET_METHOD(Constructor(), "commit", Connection, Commit, sig0);
+    EOS_SET_METHOD(Constructor(), "rollback", Connection, Rollback, sig0);
+    EOS_SET_GETTER(Constructor(), "autoCommit", Connection, GetAutoCommit);
 }
 
 Connection::Connection(Eos::Environment* environment, SQLHDBC hDbc EOS_ASYNC_ONLY_ARG(HANDLE hEvent))
     : environment_(environment)
     , EosHandle(SQL_HANDLE_DBC, hDbc EOS_ASYNC_ONLY_ARG(hEvent))
+    , driverConnection_(0)
+    , statementCacheSize_(DefaultStatementCacheSize)
+    , autoPrepare_(0)
+    , autoCommit_(true)
 {
     EOS_DEBUG_METHOD();
+
+    cacheCounters_.hits = cacheCounters_.misses = cacheCounters_.evictions = cacheCounters_.autoPrepared = 0;
+
+    // The environment must outlive its connections.
+    environment_->Ref();
 }
 
 Connection::~Connection() {
     EOS_DEBUG_METHOD();
+
+    for (auto it = statements_.begin(); it != statements_.end(); ++it)
+        (*it)->ConnectionDestroyed();
+
+    for (auto it = cachedStatements_.begin(); it != cachedStatements_.end(); ++it)
+        (*it)->Unref();
+
+    // Freed here rather than by ~EosHandle, so that the task can keep the environment 
+    // alive until the connection handle has been freed.
+    if (IsValid() && Pool())
+        FreeHandleInBackground(environment_);
+
+    environment_->Unref();
+}
+
+void Connection::RemoveStatement(Statement* stmt) {
+    auto it = std::find(statements_.begin(), statements_.end(), stmt);
+    if (it != statements_.end()) {
+        *it = statements_.back();
+        statements_.pop_back();
+    }
+}
+
+bool Connection::CheckPriorityChange() {
+    bool busy = IsBusy();
+    for (auto it = statements_.begin(); it != statements_.end() && !busy; ++it)
+        busy = (*it)->IsBusy();
+
+    if (busy) {
+        NanThrowError("The priority cannot be changed while the connection or its statements have operations queued");
+        return false;
+    }
+
+    return true;
+}
+
+void Connection::Connected() {
+    // Answered by the driver manager, without calling the driver.
+    SQLULEN driverConnection = 0;
+    auto ret = SQLGetInfoW(GetHandle(), SQL_DRIVER_HDBC, &driverConnection, sizeof(driverConnection), nullptr);
+    driverConnection_ = SQL_SUCCEEDED(ret) ? driverConnection : 0;
+
+    environment_->ConnectionOpened(driverConnection_);
+}
+
+void Connection::Disconnected() {
+    environment_->ConnectionClosed(driverConnection_);
+    driverConnection_ = 0;
+}
+
+Statement* Connection::TakeCachedStatement(const SqlText& sql) {
+    for (auto it = cachedStatements_.begin(); it != cachedStatements_.end();) {
+        auto stmt = *it;
+
+        // Statements can still be used after they have been released.
+        if (stmt->GetHandle() == SQL_NULL_HANDLE) {
+            it = cachedStatements_.erase(it);
+            stmt->Unref();
+            continue;
+        }
+
+        if (!stmt->IsBusy() && !stmt->HasPendingTasks() && stmt->PreparedSql() == sql) {
+            cachedStatements_.erase(it);
+            return stmt;
+        }
+
+        ++it;
+    }
+
+    return nullptr;
+}
+
+void Connection::ReleaseStatement(Statement* stmt) {
+    if (IsCached(stmt))
+        return;
+
+    if (!statementCacheSize_ || stmt->PreparedSql().empty())
+        return stmt->Discard();
+
+    stmt->Ref();
+    cachedStatements_.push_front(stmt);
+    TrimStatementCache();
+}
+
+bool Connection::IsCached(Statement* stmt) const {
+    return std::find(cachedStatements_.begin(), cachedStatements_.end(), stmt) != cachedStatements_.end();
+}
+
+void Connection::TrimStatementCache() {
+    while (cachedStatements_.size() > statementCacheSize_) {
+        auto stmt = cachedStatements_.back();
+        cachedStatements_.pop_back();
+        cacheCounters_.evictions++;
+
+        stmt->Discard();
+        stmt->Unref();
+    }
+}
+
+void Connection::ClearStatementCache() {
+    while (!cachedStatements_.empty()) {
+        auto stmt = cachedStatements_.front();
+        cachedStatements_.pop_front();
+
+        stmt->Discard();
+        stmt->Unref();
+    }
+
+    executions_.clear();
+}
+
+bool Connection::ShouldAutoPrepare(const SqlText& sql) {
+    if (!autoPrepare_)
+        return false;
+
+    // Ad hoc SQL would otherwise grow the counts without limit.
+    if (executions_.size() >= MaxExecutionCounts && executions_.find(sql) == executions_.end())
+        executions_.clear();
+
+    if (++executions_[sql] < autoPrepare_)
+        return false;
+
+    executions_.erase(sql);
+    return true;
+}
+
+NAN_METHOD(Connection::StatementCacheStats) {
+    EOS_DEBUG_METHOD();
+
+    auto result = NanNew<Object>();
+    result->Set(NanSymbol("size"), NanNew<Integer>(static_cast<int32_t>(cachedStatements_.size())));
+    result->Set(NanSymbol("hits"), NanNew<Number>(static_cast<double>(cacheCounters_.hits)));
+    result->Set(NanSymbol("misses"), NanNew<Number>(static_cast<double>(cacheCounters_.misses)));
+    result->Set(NanSymbol("evictions"), NanNew<Number>(static_cast<double>(cacheCounters_.evictions)));
+    result->Set(NanSymbol("autoPrepared"), NanNew<Number>(static_cast<double>(cacheCounters_.autoPrepared)));
+
+    EosMethodReturnValue(result);
+}
+
+NAN_GETTER(Connection::GetStatementCacheSize) const {
+    EosMethodReturnValue(NanNew<Integer>(static_cast<int32_t>(statementCacheSize_)));
+}
+
+NAN_SETTER(Connection::SetStatementCacheSize) {
+    if (!value->IsUint32()) {
+        NanThrowRangeError("statementCacheSize must be a non-negative integer");
+        return;
+    }
+
+    statementCacheSize_ = value->Uint32Value();
+    TrimStatementCache();
+}
+
+NAN_GETTER(Connection::GetAutoPrepare) const {
+    EosMethodReturnValue(NanNew<Integer>(static_cast<int32_t>(autoPrepare_)));
+}
+
+NAN_SETTER(Connection::SetAutoPrepare) {
+    if (!value->IsUint32()) {
+        NanThrowRangeError("autoPrepare must be a non-negative integer");
+        return;
+    }
+
+    autoPrepare_ = value->Uint32Value();
+    executions_.clear();
+}
+
+NAN_GETTER(Connection::GetAutoCommit) const {
+    EosMethodReturnValue(NanNew<Boolean>(autoCommit_));
 }
 
 NAN_METHOD(Connection::New) {
@@ -49,10 +239,17 @@ NAN_METHOD(Connection::New) {
     auto env = ObjectWrap::Unwrap<Environment>(args[0]->ToObject());
         
     SQLHDBC hDbc;
+    SQLRETURN ret;
 
-    auto ret = SQLAllocHandle(SQL_HANDLE_DBC, env->GetHandle(), &hDbc);
-    if (!SQL_SUCCEEDED(ret))
-        return NanThrowError(env->GetLastError());
+    // Environment.newConnection(callback) allocates the handle on a worker thread, and 
+    // Environment.openMany() also passes the thread which connected it.
+    if (args.Length() > 1 && args[1]->IsExternal()) {
+        hDbc = static_cast<SQLHDBC>(args[1].As<External>()->Value());
+    } else {
+        ret = SQLAllocHandle(SQL_HANDLE_DBC, env->GetHandle(), &hDbc);
+        if (!SQL_SUCCEEDED(ret))
+            return NanThrowError(env->GetLastError());
+    }
     
 #if defined(EOS_ENABLE_ASYNC_NOTIFICATIONS)
     // Attempt to enable asynchronous notifications
@@ -87,16 +284,23 @@ NAN_METHOD(Connection::New) {
     }
 #endif
 
-    (new Connection(env, hDbc EOS_ASYNC_ONLY_ARG(hEvent)))->Wrap(args.Holder());
+    auto affinity = args.Length() > 2 && args[1]->IsExternal() && args[2]->IsUint32()
+        ? args[2]->Uint32Value()
+        : env->Pool()->NextAffinity();
+
+    auto conn = new Connection(env, hDbc EOS_ASYNC_ONLY_ARG(hEvent));
+    conn->SetPool(env->Pool(), affinity);
+    conn->SetPriority(env->Priority());
+    conn->Wrap(args.Holder());
 
     NanReturnValue(args.Holder());
 }
 
-NAN_METHOD(Connection::NewStatement) {
+NAN_METHOD(Connection::BeginFree) {
     EOS_DEBUG_METHOD();
 
-    Handle<Value> argv[1] = { NanObjectWrapHandle(this) };
-    EosMethodReturnValue(Statement::Constructor()->GetFunction()->NewInstance(1, argv));
+    Handle<Value> argv[] = { NanObjectWrapHandle(this), args[0] };
+    return Begin<FreeOperation<Connection> >(argv);
 }
 
 NAN_METHOD(Connection::NativeSql) {
@@ -179,4 +383,7 @@ void Connection::DisableAsynchronousNotifications() {
 }
 #endif
 
+template<> Persistent<FunctionTemplate> Operation<Connection, FreeOperation<Connection> >::constructor_ = Persistent<FunctionTemplate>();
+
 namespace { ClassInitializer<Connection> ci; }
+namespace { ClassInitializer<FreeOperation<Connection> > cf; }
@@ -1,4 +1,5 @@
 #include "conn.hpp"
+#include "stmt.hpp"
 
 using namespace Eos;
 
@@ -21,14 +22,24 @@ namespace Eos {
             return SQLDisconnect(
                 Owner()->GetHandle());
         }
+
+        void CallbackOverride(SQLRETURN ret) {
+            EOS_DEBUG_METHOD();
+
+            if (!SQL_SUCCEEDED(ret))
+                return CallbackErrorOverride(ret);
+
+            Owner()->Disconnected();
+            MakeCallback(0, nullptr);
+        }
     };
 }
 
 NAN_METHOD(Connection::Disconnect) {
     EOS_DEBUG_METHOD();
 
-    if (args.Length() < 1)
-        return NanThrowError("Connection::Disconnect() requires a callback");
+    // Prepared statements do not survive disconnecting.
+    ClearStatementCache();
 
     Handle<Value> argv[] = { NanObjectWrapHandle(this), args[0] };
     return Begin<DisconnectOperation>(argv);
@@ -38,6 +38,16 @@ namespace Eos {
                 SQL_DRIVER_NOPROMPT);
         }
 
+        void CallbackOverride(SQLRETURN ret) {
+            EOS_DEBUG_METHOD();
+
+            if (!SQL_SUCCEEDED(ret))
+                return CallbackErrorOverride(ret);
+
+            Owner()->Connected();
+            MakeCallback(0, nullptr);
+        }
+
     protected:
         SQLSMALLINT cchCompleted_; // Not used
         WStringValue connectionString_;
@@ -47,8 +57,8 @@ namespace Eos {
 NAN_METHOD(Connection::DriverConnect) {
     EOS_DEBUG_METHOD();
 
-    if (args.Length() < 2)
-        return NanThrowError("Connection::DriverConnect() requires 2 arguments");
+    if (args.Length() < 1)
+        return NanThrowError("Connection::DriverConnect() requires a connection string");
 
     Handle<Value> argv[] = { NanObjectWrapHandle(this), args[0], args[1] };
     return Begin<DriverConnectOperation>(argv);
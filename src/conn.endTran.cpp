@@ -0,0 +1,56 @@
+#include "conn.hpp"
+
+using namespace Eos;
+
+namespace Eos {
+    // Commits or rolls back the connection's transaction. Autocommit stays off, so the next
+    // statement starts a new transaction.
+    struct EndTranOperation : Operation<Connection, EndTranOperation> {
+        EndTranOperation(SQLSMALLINT completionType)
+            : completionType_(completionType)
+        {
+            EOS_DEBUG_METHOD_FMT(L"completionType = %i", completionType);
+        }
+
+        static EOS_OPERATION_CONSTRUCTOR(New, Connection) {
+            EOS_DEBUG_METHOD();
+
+            if (args.Length() < 3)
+                return NanError("Too few arguments");
+
+            auto completionType = args[1]->IsTrue() ? SQL_COMMIT : SQL_ROLLBACK;
+            (new EndTranOperation(completionType))->Wrap(args.Holder());
+
+            EOS_OPERATION_CONSTRUCTOR_RETURN();
+        }
+
+        static const char* Name() { return "EndTranOperation"; }
+
+    protected:
+        SQLRETURN CallOverride() {
+            EOS_DEBUG_METHOD();
+
+            return SQLEndTran(SQL_HANDLE_DBC, Owner()->GetHandle(), completionType_);
+        }
+
+    private:
+        SQLSMALLINT completionType_;
+    };
+}
+
+NAN_METHOD(Connection::Commit) {
+    EOS_DEBUG_METHOD();
+
+    Handle<Value> argv[] = { NanObjectWrapHandle(this), NanTrue(), args[0] };
+    return Begin<EndTranOperation>(argv);
+}
+
+NAN_METHOD(Connection::Rollback) {
+    EOS_DEBUG_METHOD();
+
+    Handle<Value> argv[] = { NanObjectWrapHandle(this), NanFalse(), args[0] };
+    return Begin<EndTranOperation>(argv);
+}
+
+template<> Persistent<FunctionTemplate> Operation<Connection, EndTranOperation>::constructor_ = Persistent<FunctionTemplate>();
+namespace { ClassInitializer<EndTranOperation> ci; }
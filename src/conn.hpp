@@ -4,7 +4,17 @@
 #include "env.hpp"
 #include "handle.hpp"
 
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
 namespace Eos {
+    struct Statement;
+
+    // SQL text, as the key of the statement cache.
+    typedef std::basic_string<SQLWCHAR> SqlText;
+
     struct Connection : EosHandle {
         static void Init(Handle<Object> exports);
 
@@ -13,6 +23,9 @@ namespace Eos {
 
         static const int HandleType = SQL_HANDLE_DBC;
 
+    protected:
+        NAN_METHOD(BeginFree);
+
     public:
         // JS methods
         static NAN_METHOD(New);
@@ -22,14 +35,80 @@ namespace Eos {
         NAN_METHOD(NewStatement);
         NAN_METHOD(NativeSql);
         NAN_METHOD(Disconnect);
+        NAN_METHOD(Reset);
+        NAN_METHOD(PrepareCached);
+        NAN_METHOD(StatementCacheStats);
+        NAN_METHOD(SetAutoCommit);
+        NAN_METHOD(BeginTransaction);
+        NAN_METHOD(Commit);
+        NAN_METHOD(Rollback);
+
+        NAN_GETTER(GetStatementCacheSize) const;
+        NAN_SETTER(SetStatementCacheSize);
+        NAN_GETTER(GetAutoPrepare) const;
+        NAN_SETTER(SetAutoPrepare);
+        NAN_GETTER(GetAutoCommit) const;
 
     public:
         // Non-JS methods
         static Handle<FunctionTemplate> Constructor() { return NanNew(constructor_); }
         void DisableAsynchronousNotifications();
 
+        // The statements allocated on this connection which have not been destroyed. reset()
+        // frees them.
+        const std::vector<Statement*>& Statements() const { return statements_; }
+        void AddStatement(Statement* stmt) { statements_.push_back(stmt); }
+        void RemoveStatement(Statement* stmt);
+
+        // The lane is shared with the statements, and cannot change while any of their 
+        // operations, or the connection's, are queued in the old one.
+        bool CheckPriorityChange();
+
+        // Called by the connect and disconnect operations when they succeed, to count 
+        // connections reused from the driver manager's pool.
+        void Connected();
+        void Disconnected();
+
+        // Whether autocommit is on, as last set by setAutoCommit(), beginTransaction() or
+        // reset(). It is not read from the driver, which could block on the worker thread.
+        bool AutoCommit() const { return autoCommit_; }
+        void RecordAutoCommit(bool autoCommit) { autoCommit_ = autoCommit; }
+
+        // The statement cache holds statements given to Statement.release() which have 
+        // prepared SQL, most recently released first, for prepareCached() to hand out again.
+        // Cached statements are kept alive by the cache.
+        Statement* TakeCachedStatement(const SqlText& sql);
+        void ReleaseStatement(Statement* stmt);
+        bool IsCached(Statement* stmt) const;
+        void ClearStatementCache();
+
+        unsigned int StatementCacheSize() const { return statementCacheSize_; }
+
+        // Counts an execDirect() of sql, and returns true once it has been executed 
+        // autoPrepare times, when the statement should prepare it instead. The operation
+        // counts it as autoPrepared if it does.
+        unsigned int AutoPrepare() const { return autoPrepare_; }
+        bool ShouldAutoPrepare(const SqlText& sql);
+
+        struct StatementCacheCounters {
+            uint64_t hits, misses, evictions, autoPrepared;
+        };
+
+        StatementCacheCounters& CacheCounters() { return cacheCounters_; }
+
+        enum { DefaultStatementCacheSize = 16, MaxExecutionCounts = 1024 };
+
     private:
+        void TrimStatementCache();
+
         Eos::Environment* environment_;
+        SQLULEN driverConnection_;
+        std::vector<Statement*> statements_;
+        std::list<Statement*> cachedStatements_;
+        std::map<SqlText, unsigned int> executions_;
+        unsigned int statementCacheSize_, autoPrepare_;
+        bool autoCommit_;
+        StatementCacheCounters cacheCounters_;
         static Persistent<FunctionTemplate> constructor_;
     };
 }
@@ -0,0 +1,77 @@
+#include "conn.hpp"
+#include "stmt.hpp"
+
+using namespace Eos;
+
+namespace Eos {
+    struct NewStatementOperation : Operation<Connection, NewStatementOperation> {
+        // SQLAllocHandle cannot be run asynchronously.
+        enum { Pollable = false, AsyncCapable = false };
+
+        NewStatementOperation() : hStmt_(SQL_NULL_HANDLE) {
+            EOS_DEBUG_METHOD();
+        }
+
+        static EOS_OPERATION_CONSTRUCTOR(New, Connection) {
+            EOS_DEBUG_METHOD();
+
+            if (args.Length() < 2)
+                return NanError("Too few arguments");
+
+            (new NewStatementOperation())->Wrap(args.Holder());
+
+            EOS_OPERATION_CONSTRUCTOR_RETURN();
+        }
+
+        void CallbackOverride(SQLRETURN ret) {
+            EOS_DEBUG_METHOD();
+
+            if (!SQL_SUCCEEDED(ret))
+                return CallbackErrorOverride(ret);
+
+            // If Statement::New throws, it frees the handle itself.
+            TryCatch tc;
+            Handle<Value> ctorArgs[] = { NanObjectWrapHandle(Owner()), NanNew<External>(hStmt_) };
+            auto stmt = Statement::Constructor()->GetFunction()->NewInstance(2, ctorArgs);
+            if (stmt.IsEmpty()) {
+                Handle<Value> argv[] = { tc.Exception() };
+                return MakeCallback(argv);
+            }
+
+            Handle<Value> argv[] = { NanUndefined(), stmt };
+            MakeCallback(argv);
+        }
+
+        static const char* Name() { return "NewStatementOperation"; }
+
+    protected:
+        SQLRETURN CallOverride() {
+            EOS_DEBUG_METHOD();
+
+            return SQLAllocHandle(
+                SQL_HANDLE_STMT,
+                Owner()->GetHandle(),
+                &hStmt_);
+        }
+
+    private:
+        SQLHSTMT hStmt_;
+    };
+}
+
+NAN_METHOD(Connection::NewStatement) {
+    EOS_DEBUG_METHOD();
+
+    // With a callback, the handle is allocated on the connection's thread, after the 
+    // operations queued on the connection.
+    if (args.Length() > 0 && args[0]->IsFunction()) {
+        Handle<Value> argv[] = { NanObjectWrapHandle(this), args[0] };
+        return Begin<NewStatementOperation>(argv);
+    }
+
+    Handle<Value> argv[1] = { NanObjectWrapHandle(this) };
+    EosMethodReturnValue(Statement::Constructor()->GetFunction()->NewInstance(1, argv));
+}
+
+template<> Persistent<FunctionTemplate> Operation<Connection, NewStatementOperation>::constructor_ = Persistent<FunctionTemplate>();
+namespace { ClassInitializer<NewStatementOperation> ci; }
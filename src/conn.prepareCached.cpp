@@ -0,0 +1,160 @@
+#include "conn.hpp"
+#include "stmt.hpp"
+
+using namespace Eos;
+
+namespace Eos {
+    // Allocates a statement and prepares it, on the connection's thread, for 
+    // Connection.prepareCached() when the statement cache has no statement for the SQL.
+    struct PrepareCachedOperation : Operation<Connection, PrepareCachedOperation> {
+        // SQLAllocHandle cannot be run asynchronously.
+        enum { Pollable = false, AsyncCapable = false };
+
+        PrepareCachedOperation(Handle<Value> sql)
+            : sql_(sql)
+            , hStmt_(SQL_NULL_HANDLE)
+        {
+            EOS_DEBUG_METHOD_FMT(L"sql = %ls", *sql_);
+        }
+
+        static EOS_OPERATION_CONSTRUCTOR(New, Connection) {
+            EOS_DEBUG_METHOD();
+
+            if (args.Length() < 3)
+                return NanError("Too few arguments");
+
+            if (!args[1]->IsString())
+                return NanTypeError("Statement SQL should be a string");
+
+            (new PrepareCachedOperation(args[1]))->Wrap(args.Holder());
+
+            EOS_OPERATION_CONSTRUCTOR_RETURN();
+        }
+
+        void CallbackOverride(SQLRETURN ret) {
+            EOS_DEBUG_METHOD();
+
+            if (!SQL_SUCCEEDED(ret))
+                return CallbackErrorOverride(ret);
+
+            // If Statement::New throws, it frees the handle itself.
+            TryCatch tc;
+            Handle<Value> ctorArgs[] = { NanObjectWrapHandle(Owner()), NanNew<External>(hStmt_) };
+            auto stmt = Statement::Constructor()->GetFunction()->NewInstance(2, ctorArgs);
+            if (stmt.IsEmpty()) {
+                Handle<Value> argv[] = { tc.Exception() };
+                return MakeCallback(argv);
+            }
+
+            ObjectWrap::Unwrap<Statement>(stmt)->SetPreparedSql(SqlText(*sql_, sql_.length()));
+
+            Handle<Value> argv[] = { NanUndefined(), stmt };
+            MakeCallback(argv);
+        }
+
+        // If the statement was allocated, the error is on the statement handle.
+        void CallbackErrorOverride(SQLRETURN ret) {
+            if (hStmt_ == SQL_NULL_HANDLE)
+                return Operation<Connection, PrepareCachedOperation>::CallbackErrorOverride(ret);
+
+            Handle<Value> argv[] = { Eos::GetLastError(SQL_HANDLE_STMT, hStmt_) };
+            SQLFreeHandle(SQL_HANDLE_STMT, hStmt_);
+            hStmt_ = SQL_NULL_HANDLE;
+            MakeCallback(argv);
+        }
+
+        static const char* Name() { return "PrepareCachedOperation"; }
+
+    protected:
+        SQLRETURN CallOverride() {
+            EOS_DEBUG_METHOD();
+
+            auto ret = SQLAllocHandle(SQL_HANDLE_STMT, Owner()->GetHandle(), &hStmt_);
+            if (!SQL_SUCCEEDED(ret)) {
+                hStmt_ = SQL_NULL_HANDLE;
+                return ret;
+            }
+
+            return SQLPrepareW(hStmt_, *sql_, sql_.length());
+        }
+
+    private:
+        WStringValue sql_;
+        SQLHSTMT hStmt_;
+    };
+
+    // Closes the cursor left open on a statement from the statement cache, if any, before 
+    // handing it out again.
+    struct ReuseStatementOperation : Operation<Statement, ReuseStatementOperation> {
+        // SQLFreeStmt cannot be run asynchronously.
+        enum { Pollable = false, AsyncCapable = false };
+
+        static EOS_OPERATION_CONSTRUCTOR(New, Statement) {
+            EOS_DEBUG_METHOD();
+
+            if (args.Length() < 2)
+                return NanError("Too few arguments");
+
+            (new ReuseStatementOperation())->Wrap(args.Holder());
+
+            EOS_OPERATION_CONSTRUCTOR_RETURN();
+        }
+
+        void CallbackOverride(SQLRETURN ret) {
+            EOS_DEBUG_METHOD();
+
+            if (!SQL_SUCCEEDED(ret))
+                return CallbackErrorOverride(ret);
+
+            Handle<Value> argv[] = { NanUndefined(), NanObjectWrapHandle(Owner()) };
+            MakeCallback(argv);
+        }
+
+        static const char* Name() { return "ReuseStatementOperation"; }
+
+    protected:
+        SQLRETURN CallOverride() {
+            EOS_DEBUG_METHOD();
+
+            return SQLFreeStmt(Owner()->GetHandle(), SQL_CLOSE);
+        }
+    };
+}
+
+NAN_METHOD(Connection::PrepareCached) {
+    EOS_DEBUG_METHOD();
+
+    if (args.Length() < 1 || !args[0]->IsString())
+        return NanThrowTypeError("Connection::PrepareCached() requires an SQL string");
+
+    WStringValue sql(args[0]);
+    if (auto stmt = TakeCachedStatement(SqlText(*sql, sql.length()))) {
+        cacheCounters_.hits++;
+
+        // The local handle keeps the statement alive now that the cache no longer does, 
+        // until the operation takes over.
+        auto handle = NanObjectWrapHandle(stmt);
+        stmt->Unref();
+        return stmt->BeginReuse(args);
+    }
+
+    cacheCounters_.misses++;
+
+    Handle<Value> argv[] = { NanObjectWrapHandle(this), args[0], args[1] };
+    return Begin<PrepareCachedOperation>(argv);
+}
+
+NAN_METHOD(Statement::BeginReuse) {
+    EOS_DEBUG_METHOD();
+
+    // prepareCached(sql, [callback])
+    Handle<Value> argv[] = { NanObjectWrapHandle(this), args[1] };
+    return Begin<ReuseStatementOperation>(argv);
+}
+
+template<> Persistent<FunctionTemplate> Operation<Connection, PrepareCachedOperation>::constructor_ = Persistent<FunctionTemplate>();
+template<> Persistent<FunctionTemplate> Operation<Statement, ReuseStatementOperation>::constructor_ = Persistent<FunctionTemplate>();
+namespace { 
+    ClassInitializer<PrepareCachedOperation> ci; 
+    ClassInitializer<ReuseStatementOperation> ci2; 
+}
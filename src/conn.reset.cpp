@@ -0,0 +1,95 @@
+#include "conn.hpp"
+#include "stmt.hpp"
+
+using namespace Eos;
+
+namespace Eos {
+    // Returns a connection to the state it was in after connecting: the statements allocated
+    // on it are freed (closing their cursors and releasing their bindings), any transaction
+    // is rolled back, and autocommit is turned back on. Statements in the statement cache 
+    // are kept, since their bindings were reset when they were released.
+    struct ResetOperation : Operation<Connection, ResetOperation> {
+        enum { Pollable = false, AsyncCapable = false };
+
+        ResetOperation() {
+            EOS_DEBUG_METHOD();
+        }
+
+        static EOS_OPERATION_CONSTRUCTOR(New, Connection) {
+            EOS_DEBUG_METHOD();
+
+            if (args.Length() < 2)
+                return NanError("Too few arguments");
+
+            auto& statements = owner->Statements();
+            for (auto it = statements.begin(); it != statements.end(); ++it) {
+                if ((*it)->IsBusy() || (*it)->HasPendingTasks())
+                    return NanError("Cannot reset the connection while its statements have operations in progress");
+            }
+
+            // The statements are forgotten now, so that they cannot be used while the 
+            // handles are being freed.
+            auto op = new ResetOperation();
+            for (auto it = statements.begin(); it != statements.end(); ++it) {
+                if (owner->IsCached(*it))
+                    continue;
+
+                auto hStmt = (*it)->TakeHandle();
+                if (hStmt != SQL_NULL_HANDLE)
+                    op->statements_.push_back(hStmt);
+            }
+
+            op->Wrap(args.Holder());
+
+            EOS_OPERATION_CONSTRUCTOR_RETURN();
+        }
+
+        void CallbackOverride(SQLRETURN ret) {
+            EOS_DEBUG_METHOD();
+
+            if (!SQL_SUCCEEDED(ret))
+                return CallbackErrorOverride(ret);
+
+            Owner()->RecordAutoCommit(true);
+            MakeCallback(0, nullptr);
+        }
+
+        static const char* Name() { return "ResetOperation"; }
+
+    protected:
+        SQLRETURN CallOverride() {
+            EOS_DEBUG_METHOD();
+
+            for (auto it = statements_.begin(); it != statements_.end(); ++it) {
+                if (!SQL_SUCCEEDED(SQLFreeHandle(SQL_HANDLE_STMT, *it)))
+                    EOS_DEBUG(L"Unable to free statement 0x%p\n", *it);
+            }
+            statements_.clear();
+
+            auto hDbc = Owner()->GetHandle();
+
+            auto ret = SQLEndTran(SQL_HANDLE_DBC, hDbc, SQL_ROLLBACK);
+            if (!SQL_SUCCEEDED(ret))
+                return ret;
+
+            return SQLSetConnectAttrW(
+                hDbc,
+                SQL_ATTR_AUTOCOMMIT,
+                (SQLPOINTER)SQL_AUTOCOMMIT_ON,
+                SQL_IS_UINTEGER);
+        }
+
+    private:
+        std::vector<SQLHSTMT> statements_;
+    };
+}
+
+NAN_METHOD(Connection::Reset) {
+    EOS_DEBUG_METHOD();
+
+    Handle<Value> argv[] = { NanObjectWrapHandle(this), args[0] };
+    return Begin<ResetOperation>(argv);
+}
+
+template<> Persistent<FunctionTemplate> Operation<Connection, ResetOperation>::constructor_ = Persistent<FunctionTemplate>();
+namespace { ClassInitializer<ResetOperation> ci; }
@@ -0,0 +1,72 @@
+#include "conn.hpp"
+
+using namespace Eos;
+
+namespace Eos {
+    // Turns autocommit on or off. Turning it on commits the open transaction, if any, so it 
+    // can involve the server.
+    struct SetAutoCommitOperation : Operation<Connection, SetAutoCommitOperation> {
+        SetAutoCommitOperation(bool autoCommit)
+            : autoCommit_(autoCommit)
+        {
+            EOS_DEBUG_METHOD_FMT(L"autoCommit = %i", autoCommit);
+        }
+
+        static EOS_OPERATION_CONSTRUCTOR(New, Connection) {
+            EOS_DEBUG_METHOD();
+
+            if (args.Length() < 3)
+                return NanError("Too few arguments");
+
+            (new SetAutoCommitOperation(args[1]->BooleanValue()))->Wrap(args.Holder());
+
+            EOS_OPERATION_CONSTRUCTOR_RETURN();
+        }
+
+        void CallbackOverride(SQLRETURN ret) {
+            EOS_DEBUG_METHOD();
+
+            if (!SQL_SUCCEEDED(ret))
+                return CallbackErrorOverride(ret);
+
+            Owner()->RecordAutoCommit(autoCommit_);
+            MakeCallback(0, nullptr);
+        }
+
+        static const char* Name() { return "SetAutoCommitOperation"; }
+
+    protected:
+        SQLRETURN CallOverride() {
+            EOS_DEBUG_METHOD();
+
+            return SQLSetConnectAttrW(
+                Owner()->GetHandle(),
+                SQL_ATTR_AUTOCOMMIT,
+                (SQLPOINTER)(autoCommit_ ? SQL_AUTOCOMMIT_ON : SQL_AUTOCOMMIT_OFF),
+                SQL_IS_UINTEGER);
+        }
+
+    private:
+        bool autoCommit_;
+    };
+}
+
+NAN_METHOD(Connection::SetAutoCommit) {
+    EOS_DEBUG_METHOD();
+
+    if (args.Length() < 1)
+        return NanThrowError("Connection::SetAutoCommit() requires a boolean");
+
+    Handle<Value> argv[] = { NanObjectWrapHandle(this), args[0], args[1] };
+    return Begin<SetAutoCommitOperation>(argv);
+}
+
+NAN_METHOD(Connection::BeginTransaction) {
+    EOS_DEBUG_METHOD();
+
+    Handle<Value> argv[] = { NanObjectWrapHandle(this), NanFalse(), args[0] };
+    return Begin<SetAutoCommitOperation>(argv);
+}
+
+template<> Persistent<FunctionTemplate> Operation<Connection, SetAutoCommitOperation>::constructor_ = Persistent<FunctionTemplate>();
+namespace { ClassInitializer<SetAutoCommitOperation> ci; }
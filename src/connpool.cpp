@@ -0,0 +1,558 @@
+#include "connpool.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace Eos;
+
+Persistent<FunctionTemplate> ConnectionPool::constructor_;
+
+namespace {
+    // Reads an optional non-negative integer option.
+    bool GetOption(Handle<Object> options, const char* name, unsigned int& value) {
+        auto option = options->Get(NanSymbol(name));
+        if (option->IsUndefined())
+            return true;
+
+        if (!option->IsUint32())
+            return false;
+
+        value = option->Uint32Value();
+        return true;
+    }
+
+    const uint64_t NanosecondsPerMillisecond = 1000 * 1000;
+}
+
+void ConnectionPool::Init(Handle<Object> exports) {
+    EOS_DEBUG_METHOD();
+
+    NanAssignPersistent(constructor_, NanNew<FunctionTemplate>(New));
+    Constructor()->SetClassName(NanSymbol("Pool"));
+    Constructor()->InstanceTemplate()->SetInternalFieldCount(1);
+
+    auto sig0 = NanNew<Signature>(Constructor());
+    EOS_SET_METHOD(Constructor(), "acquire", ConnectionPool, Acquire, sig0);
+    EOS_SET_METHOD(Constructor(), "release", ConnectionPool, Release, sig0);
+    EOS_SET_METHOD(Constructor(), "destroy", ConnectionPool, Destroy, sig0);
+    EOS_SET_METHOD(Constructor(), "close", ConnectionPool, Close, sig0);
+    EOS_SET_METHOD(Constructor(), "stats", ConnectionPool, Stats, sig0);
+
+    exports->Set(NanSymbol("Pool"), Constructor()->GetFunction() IF_NODE_12(EOS_COMMA ReadOnly));
+}
+
+NAN_METHOD(ConnectionPool::New) {
+    EOS_DEBUG_METHOD();
+
+    NanScope();
+
+    if (!args.IsConstructCall()) {
+        Handle<Value> argv[3] = { args[0], args[1], args[2] };
+        NanReturnValue(Constructor()->GetFunction()->NewInstance(3, argv));
+    }
+
+    if (!Environment::Constructor()->HasInstance(args[0]))
+        return NanThrowTypeError("The first argument must be an Environment");
+
+    if (!args[1]->IsString())
+        return NanThrowTypeError("The connection string must be a string");
+
+    unsigned int min = 0, max = DefaultMax;
+    unsigned int idleTimeout = DefaultIdleTimeout, acquireTimeout = DefaultAcquireTimeout;
+
+    if (args.Length() > 2 && !args[2]->IsUndefined()) {
+        if (!args[2]->IsObject())
+            return NanThrowTypeError("The options argument must be an object");
+
+        auto options = args[2].As<Object>();
+        if (!GetOption(options, "min", min) || !GetOption(options, "max", max))
+            return NanThrowRangeError("min and max must be non-negative integers");
+
+        if (max < 1 || min > max)
+            return NanThrowRangeError("max must be at least 1, and no less than min");
+
+        if (!GetOption(options, "idleTimeout", idleTimeout) || !GetOption(options, "acquireTimeout", acquireTimeout))
+            return NanThrowRangeError("Timeouts must be a non-negative number of milliseconds");
+    }
+
+    auto env = ObjectWrap::Unwrap<Environment>(args[0].As<Object>());
+    if (!env->Pool())
+        return NanThrowError("The environment has been closed.");
+
+    auto pool = new ConnectionPool(args[0].As<Object>(), args[1].As<String>());
+    pool->workerPool_ = env->Pool();
+    pool->min_ = min;
+    pool->max_ = max;
+    pool->idleTimeout_ = idleTimeout;
+    pool->acquireTimeout_ = acquireTimeout;
+    pool->Wrap(args.Holder());
+
+    pool->Fill();
+
+    NanReturnValue(args.Holder());
+}
+
+ConnectionPool::ConnectionPool(Handle<Object> env, Handle<String> connectionString)
+    : workerPool_(nullptr)
+    , connecting_(0)
+    , resetting_(0)
+    , closing_(0)
+    , min_(0)
+    , max_(DefaultMax)
+    , idleTimeout_(DefaultIdleTimeout)
+    , acquireTimeout_(DefaultAcquireTimeout)
+    , closed_(false)
+{
+    EOS_DEBUG_METHOD();
+
+    memset(&stats_, 0, sizeof(stats_));
+
+    NanAssignPersistent(env_, env);
+    NanAssignPersistent(connectionString_, connectionString);
+
+    NewCallback<&ConnectionPool::OnConnected>(connected_);
+    NewCallback<&ConnectionPool::OnReset>(reset_);
+    NewCallback<&ConnectionPool::OnDisconnected>(disconnected_);
+    NewCallback<&ConnectionPool::OnFreed>(freed_);
+
+    timer_ = new uv_timer_t();
+    timer_->data = this;
+    uv_timer_init(ObjectWrap::Unwrap<Environment>(env)->Pool()->Loop(), timer_);
+    uv_unref(reinterpret_cast<uv_handle_t*>(timer_));
+}
+
+ConnectionPool::~ConnectionPool() {
+    EOS_DEBUG_METHOD();
+
+    // Waiters and connections keep the pool alive.
+    assert(waiters_.empty() && Size() == 0 && closing_ == 0);
+
+    uv_timer_stop(timer_);
+    uv_close(reinterpret_cast<uv_handle_t*>(timer_), &ClosedCallback);
+
+    NanDisposePersistent(env_);
+    NanDisposePersistent(connectionString_);
+    NanDisposePersistent(connected_);
+    NanDisposePersistent(reset_);
+    NanDisposePersistent(disconnected_);
+    NanDisposePersistent(freed_);
+}
+
+template <ConnectionPool::Handler handler>
+NAN_METHOD(ConnectionPool::Callback) {
+    NanScope();
+
+    // The connection calls back with itself as the receiver.
+    auto pool = static_cast<ConnectionPool*>(args.Data().As<External>()->Value());
+    auto conn = ObjectWrap::Unwrap<Connection>(args.This());
+
+    (pool->*handler)(conn, args[0]);
+
+    NanReturnUndefined();
+}
+
+template <ConnectionPool::Handler handler>
+void ConnectionPool::NewCallback(Persistent<Function>& callback) {
+    auto ft = NanNew<FunctionTemplate>(&Callback<handler>, NanNew<External>(this));
+    NanAssignPersistent(callback, ft->GetFunction());
+}
+
+void ConnectionPool::Begin(Connection* conn, const char* method, Handle<Value> arg, Persistent<Function>& callback, Handler handler) {
+    auto obj = NanObjectWrapHandle(conn);
+
+    Handle<Value> argv[2];
+    int argc = 0;
+    if (!arg.IsEmpty())
+        argv[argc++] = arg;
+    argv[argc++] = NanNew(callback);
+
+    Local<Value> exception;
+    {
+        TryCatch tc;
+        obj->Get(NanSymbol(method)).As<Function>()->Call(obj, argc, argv);
+        if (tc.HasCaught())
+            exception = tc.Exception();
+    }
+
+    if (!exception.IsEmpty())
+        (this->*handler)(conn, exception);
+}
+
+bool ConnectionPool::Connect() {
+    EOS_DEBUG_METHOD();
+
+    Handle<Value> argv[1] = { NanNew(env_) };
+    Local<Object> obj;
+    {
+        TryCatch tc;
+        obj = Connection::Constructor()->GetFunction()->NewInstance(1, argv);
+        if (tc.HasCaught()) {
+            stats_.failed++;
+            if (!waiters_.empty()) {
+                auto waiter = waiters_.front();
+                waiters_.pop_front();
+                waiter->Fail(tc.Exception());
+            }
+            return false;
+        }
+    }
+
+    // Each of the pool's connections keeps the pool alive, and the pool keeps it alive.
+    auto conn = ObjectWrap::Unwrap<Connection>(obj);
+    conn->Ref();
+    Ref();
+
+    connecting_++;
+    stats_.created++;
+    Begin(conn, "driverConnect", NanNew(connectionString_), connected_, &ConnectionPool::OnConnected);
+    return true;
+}
+
+// Makes new connections until there are min of them.
+void ConnectionPool::Fill() {
+    while (!closed_ && Size() < min_ && Connect())
+        ;
+}
+
+// Hands a connection to the longest waiting caller of acquire(), or makes it idle.
+void ConnectionPool::Dispatch(Connection* conn) {
+    if (!waiters_.empty()) {
+        auto waiter = waiters_.front();
+        waiters_.pop_front();
+
+        busy_.push_back(conn);
+        waiter->Succeed(conn);
+        return;
+    }
+
+    IdleConnection idle = { conn, uv_hrtime() };
+    idle_.push_back(idle);
+}
+
+// Disconnects and frees a connection which is no longer wanted. The pool forgets it once it
+// has been freed.
+void ConnectionPool::Discard(Connection* conn) {
+    EOS_DEBUG_METHOD();
+
+    closing_++;
+    Begin(conn, "disconnect", Handle<Value>(), disconnected_, &ConnectionPool::OnDisconnected);
+}
+
+bool ConnectionPool::IsDead(Connection* conn) {
+    SQLUINTEGER dead = SQL_CD_FALSE;
+    auto ret = SQLGetConnectAttrW(conn->GetHandle(), SQL_ATTR_CONNECTION_DEAD, &dead, SQL_IS_UINTEGER, nullptr);
+
+    // Drivers which cannot tell are given the benefit of the doubt.
+    return SQL_SUCCEEDED(ret) && dead == SQL_CD_TRUE;
+}
+
+void ConnectionPool::OnConnected(Connection* conn, Handle<Value> error) {
+    EOS_DEBUG_METHOD();
+
+    connecting_--;
+
+    if (!error->IsUndefined() && !error->IsNull()) {
+        // The connection was made for the longest waiting caller, so it gets the error.
+        stats_.failed++;
+        if (!waiters_.empty()) {
+            auto waiter = waiters_.front();
+            waiters_.pop_front();
+            waiter->Fail(error);
+        }
+
+        // Never connected, so it can simply be freed when it is collected.
+        conn->Unref();
+        Unref();
+    } else if (closed_) {
+        Discard(conn);
+    } else {
+        Dispatch(conn);
+    }
+
+    Schedule();
+}
+
+void ConnectionPool::OnReset(Connection* conn, Handle<Value> error) {
+    EOS_DEBUG_METHOD();
+
+    resetting_--;
+
+    if (closed_ || (!error->IsUndefined() && !error->IsNull())) {
+        Discard(conn);
+
+        if (!closed_ && connecting_ < waiters_.size())
+            Connect();
+        Fill();
+    } else {
+        Dispatch(conn);
+    }
+
+    Schedule();
+}
+
+void ConnectionPool::OnDisconnected(Connection* conn, Handle<Value> error) {
+    // Even if disconnecting failed, there is nothing else to do but free the handle.
+    Begin(conn, "free", Handle<Value>(), freed_, &ConnectionPool::OnFreed);
+}
+
+void ConnectionPool::OnFreed(Connection* conn, Handle<Value> error) {
+    EOS_DEBUG_METHOD();
+
+    closing_--;
+
+    conn->Unref();
+    Unref();
+}
+
+NAN_METHOD(ConnectionPool::Acquire) {
+    EOS_DEBUG_METHOD();
+
+    if (args.Length() < 1 || !args[0]->IsFunction())
+        return NanThrowTypeError("acquire() requires a callback");
+
+    if (closed_)
+        return NanThrowError("The pool has been closed");
+
+    uint64_t deadline = 0;
+    if (acquireTimeout_)
+        deadline = uv_hrtime() + acquireTimeout_ * NanosecondsPerMillisecond;
+
+    auto waiter = new(nothrow) Waiter(this, args[0].As<Function>(), deadline);
+    if (!waiter)
+        return NanThrowError("Out of memory allocating the request");
+
+    // The most recently used connection is the most likely to still be alive, and leaves the
+    // others to be evicted if the pool is bigger than it needs to be.
+    while (!idle_.empty()) {
+        auto conn = idle_.back().conn;
+        idle_.pop_back();
+
+        if (IsDead(conn)) {
+            stats_.dead++;
+            Discard(conn);
+            continue;
+        }
+
+        stats_.reused++;
+        busy_.push_back(conn);
+        waiter->Succeed(conn);
+
+        Schedule();
+        NanReturnUndefined();
+    }
+
+    waiters_.push_back(waiter);
+
+    // Connections already being made will go to the callers ahead of this one.
+    if (connecting_ < waiters_.size() && Size() < max_)
+        Connect();
+
+    Schedule();
+    NanReturnUndefined();
+}
+
+NAN_METHOD(ConnectionPool::Release) {
+    EOS_DEBUG_METHOD();
+
+    if (args.Length() < 1 || !Connection::Constructor()->HasInstance(args[0]))
+        return NanThrowTypeError("release() requires a Connection");
+
+    auto conn = ObjectWrap::Unwrap<Connection>(args[0].As<Object>());
+    auto it = std::find(busy_.begin(), busy_.end(), conn);
+    if (it == busy_.end())
+        return NanThrowError("The connection is not one which was acquired from this pool");
+
+    busy_.erase(it);
+
+    resetting_++;
+    Begin(conn, "reset", Handle<Value>(), reset_, &ConnectionPool::OnReset);
+
+    NanReturnUndefined();
+}
+
+NAN_METHOD(ConnectionPool::Destroy) {
+    EOS_DEBUG_METHOD();
+
+    if (args.Length() < 1 || !Connection::Constructor()->HasInstance(args[0]))
+        return NanThrowTypeError("destroy() requires a Connection");
+
+    auto conn = ObjectWrap::Unwrap<Connection>(args[0].As<Object>());
+    auto it = std::find(busy_.begin(), busy_.end(), conn);
+    if (it == busy_.end())
+        return NanThrowError("The connection is not one which was acquired from this pool");
+
+    busy_.erase(it);
+    Discard(conn);
+
+    if (!closed_ && connecting_ < waiters_.size())
+        Connect();
+    Fill();
+
+    Schedule();
+    NanReturnUndefined();
+}
+
+NAN_METHOD(ConnectionPool::Close) {
+    EOS_DEBUG_METHOD();
+
+    if (closed_)
+        NanReturnUndefined();
+
+    closed_ = true;
+
+    // Acquired connections are closed when they are released.
+    while (!waiters_.empty()) {
+        auto waiter = waiters_.front();
+        waiters_.pop_front();
+        waiter->Fail(OdbcError("The pool has been closed"));
+    }
+
+    while (!idle_.empty()) {
+        auto conn = idle_.front().conn;
+        idle_.pop_front();
+        Discard(conn);
+    }
+
+    Schedule();
+    NanReturnUndefined();
+}
+
+NAN_METHOD(ConnectionPool::Stats) {
+    EOS_DEBUG_METHOD();
+
+    auto result = NanNew<Object>();
+    result->Set(NanSymbol("size"), NanNew<Integer>(static_cast<int32_t>(Size())));
+    result->Set(NanSymbol("idle"), NanNew<Integer>(static_cast<int32_t>(idle_.size())));
+    result->Set(NanSymbol("busy"), NanNew<Integer>(static_cast<int32_t>(busy_.size())));
+    result->Set(NanSymbol("connecting"), NanNew<Integer>(static_cast<int32_t>(connecting_)));
+    result->Set(NanSymbol("waiting"), NanNew<Integer>(static_cast<int32_t>(waiters_.size())));
+    result->Set(NanSymbol("created"), NanNew<Number>(static_cast<double>(stats_.created)));
+    result->Set(NanSymbol("reused"), NanNew<Number>(static_cast<double>(stats_.reused)));
+    result->Set(NanSymbol("failed"), NanNew<Number>(static_cast<double>(stats_.failed)));
+    result->Set(NanSymbol("dead"), NanNew<Number>(static_cast<double>(stats_.dead)));
+    result->Set(NanSymbol("evicted"), NanNew<Number>(static_cast<double>(stats_.evicted)));
+    result->Set(NanSymbol("timeouts"), NanNew<Number>(static_cast<double>(stats_.timeouts)));
+
+    EosMethodReturnValue(result);
+}
+
+// Sets the timer for the next acquire() to time out, or idle connection to be evicted.
+void ConnectionPool::Schedule() {
+    uint64_t due = 0;
+
+    for (auto it = waiters_.begin(); it != waiters_.end(); ++it) {
+        if ((*it)->deadline && (!due || (*it)->deadline < due))
+            due = (*it)->deadline;
+    }
+
+    if (idleTimeout_ && !idle_.empty() && Size() > min_) {
+        auto evict = idle_.front().since + idleTimeout_ * NanosecondsPerMillisecond;
+        if (!due || evict < due)
+            due = evict;
+    }
+
+    if (!due) {
+        uv_timer_stop(timer_);
+        return;
+    }
+
+    auto now = uv_hrtime();
+    uint64_t delay = due > now ? (due - now + NanosecondsPerMillisecond - 1) / NanosecondsPerMillisecond : 0;
+    uv_timer_start(timer_, &TimerCallback, delay, 0);
+
+    // Only callers waiting for a connection keep the process alive.
+    if (waiters_.empty())
+        uv_unref(reinterpret_cast<uv_handle_t*>(timer_));
+    else
+        uv_ref(reinterpret_cast<uv_handle_t*>(timer_));
+}
+
+#if defined(NODE_12)
+void ConnectionPool::TimerCallback(uv_timer_t* timer) {
+#else
+void ConnectionPool::TimerCallback(uv_timer_t* timer, int) {
+#endif
+    EOS_DEBUG_METHOD();
+
+    NanScope();
+
+    auto pool = static_cast<ConnectionPool*>(timer->data);
+    auto now = uv_hrtime();
+
+    // Failing a waiter may release the last reference to the pool.
+    pool->Ref();
+
+    for (auto it = pool->waiters_.begin(); it != pool->waiters_.end(); ) {
+        auto waiter = *it;
+        if (!waiter->deadline || waiter->deadline > now) {
+            ++it;
+            continue;
+        }
+
+        it = pool->waiters_.erase(it);
+        pool->stats_.timeouts++;
+        waiter->Fail(OdbcError(
+            NanNew<String>("Timed out waiting for a connection from the pool"),
+            NanNew<String>("HYT00")));
+    }
+
+    // Idle connections are evicted oldest first.
+    while (pool->idleTimeout_ && !pool->idle_.empty() && pool->Size() > pool->min_) {
+        auto& idle = pool->idle_.front();
+        if (idle.since + pool->idleTimeout_ * NanosecondsPerMillisecond > now)
+            break;
+
+        auto conn = idle.conn;
+        pool->idle_.pop_front();
+        pool->stats_.evicted++;
+        pool->Discard(conn);
+    }
+
+    pool->Schedule();
+    pool->Unref();
+}
+
+void ConnectionPool::ClosedCallback(uv_handle_t* handle) {
+    delete reinterpret_cast<uv_timer_t*>(handle);
+}
+
+ConnectionPool::Waiter::Waiter(ConnectionPool* pool, Handle<Function> callback, uint64_t deadline)
+    : deadline(deadline)
+    , pool_(pool)
+    , conn_(nullptr)
+{
+    pool_->Ref();
+    NanAssignPersistent(callback_, callback);
+}
+
+void ConnectionPool::Waiter::Succeed(Connection* conn) {
+    conn_ = conn;
+    pool_->workerPool_->Post(this);
+}
+
+void ConnectionPool::Waiter::Fail(Handle<Value> error) {
+    NanAssignPersistent(error_, error);
+    pool_->workerPool_->Post(this);
+}
+
+void ConnectionPool::Waiter::Completed() {
+    NanScope();
+
+    auto callback = NanNew(callback_);
+    NanDisposePersistent(callback_);
+
+    Handle<Value> argv[2] = { NanUndefined(), NanUndefined() };
+    if (conn_) {
+        argv[1] = NanObjectWrapHandle(conn_);
+    } else {
+        argv[0] = NanNew(error_);
+        NanDisposePersistent(error_);
+    }
+
+    MakeCompletionCallback(NanObjectWrapHandle(pool_), callback, conn_ ? 2 : 1, argv);
+
+    pool_->Unref();
+    delete this;
+}
+
+namespace { ClassInitializer<ConnectionPool> ci; }
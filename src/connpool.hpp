@@ -0,0 +1,125 @@
+#pragma once
+
+#include "eos.hpp"
+#include "env.hpp"
+#include "conn.hpp"
+
+#include <uv.h>
+#include <deque>
+#include <vector>
+
+namespace Eos {
+    // A pool of connections to one connection string, created by
+    // new Pool(env, connectionString, [options]).
+    //
+    // acquire() hands out the most recently released idle connection, once the driver has
+    // said it is not dead (SQL_ATTR_CONNECTION_DEAD, which is answered without a round trip).
+    // If there is none, a new connection is made, up to max, and otherwise the caller waits
+    // for a connection to be released, for at most acquireTimeout. release() resets the
+    // connection on its worker thread (see Connection.reset()) before handing it out again.
+    // Connections which have been idle for longer than idleTimeout are closed, down to min.
+    //
+    // The pool keeps itself and its connections alive until close() is called.
+    struct ConnectionPool : ObjectWrap {
+        static void Init(Handle<Object> exports);
+        static NAN_METHOD(New);
+
+        NAN_METHOD(Acquire);
+        NAN_METHOD(Release);
+        NAN_METHOD(Destroy);
+        NAN_METHOD(Close);
+        NAN_METHOD(Stats);
+
+        static Handle<FunctionTemplate> Constructor() { return NanNew(constructor_); }
+
+        enum { DefaultMax = 10, DefaultIdleTimeout = 30000, DefaultAcquireTimeout = 30000 };
+
+    private:
+        ConnectionPool(Handle<Object> env, Handle<String> connectionString);
+        ~ConnectionPool();
+
+        // A call to acquire() which has not yet been given a connection, or an error. Once
+        // it has, it is posted to the worker pool, which calls it back on a later loop
+        // iteration.
+        struct Waiter : WorkerPool::Task {
+            Waiter(ConnectionPool* pool, Handle<Function> callback, uint64_t deadline);
+
+            void Succeed(Connection* conn);
+            void Fail(Handle<Value> error);
+
+            void Run() { }
+            void Completed();
+
+            uint64_t deadline;
+
+        private:
+            ConnectionPool* pool_;
+            Connection* conn_;
+            Persistent<Function> callback_;
+            Persistent<Value> error_;
+        };
+
+        struct IdleConnection {
+            Connection* conn;
+            uint64_t since;
+        };
+
+        typedef void (ConnectionPool::*Handler)(Connection* conn, Handle<Value> error);
+
+        template <Handler handler>
+        static NAN_METHOD(Callback);
+
+        template <Handler handler>
+        void NewCallback(Persistent<Function>& callback);
+
+        // Calls conn[method]([arg], callback). If the method throws instead of beginning
+        // an operation, handler is called with the exception straight away.
+        void Begin(Connection* conn, const char* method, Handle<Value> arg, Persistent<Function>& callback, Handler handler);
+
+        bool Connect();
+        void Dispatch(Connection* conn);
+        void Discard(Connection* conn);
+        void Fill();
+        void Schedule();
+        static bool IsDead(Connection* conn);
+
+        void OnConnected(Connection* conn, Handle<Value> error);
+        void OnReset(Connection* conn, Handle<Value> error);
+        void OnDisconnected(Connection* conn, Handle<Value> error);
+        void OnFreed(Connection* conn, Handle<Value> error);
+
+#if defined(NODE_12)
+        static void TimerCallback(uv_timer_t* timer);
+#else
+        static void TimerCallback(uv_timer_t* timer, int status);
+#endif
+        static void ClosedCallback(uv_handle_t* handle);
+
+        // Connections which are idle, busy (acquired), or on their way to being one or the
+        // other. Connections being closed no longer count towards the size of the pool.
+        unsigned int Size() const {
+            return static_cast<unsigned int>(idle_.size() + busy_.size()) + connecting_ + resetting_;
+        }
+
+        Persistent<Object> env_;
+        Persistent<String> connectionString_;
+        Persistent<Function> connected_, reset_, disconnected_, freed_;
+
+        WorkerPool* workerPool_;
+        uv_timer_t* timer_;
+
+        std::deque<IdleConnection> idle_;
+        std::vector<Connection*> busy_;
+        std::deque<Waiter*> waiters_;
+        unsigned int connecting_, resetting_, closing_;
+
+        unsigned int min_, max_, idleTimeout_, acquireTimeout_;
+        bool closed_;
+
+        struct {
+            uint64_t created, reused, failed, dead, evicted, timeouts;
+        } stats_;
+
+        static Persistent<FunctionTemplate> constructor_;
+    };
+}
@@ -0,0 +1,232 @@
+#include "datasink.hpp"
+
+#include <cstring>
+
+using namespace Eos;
+
+Persistent<FunctionTemplate> DataSink::constructor_;
+
+void DataSink::Init(Handle<Object> exports) {
+    NanAssignPersistent(constructor_, NanNew<FunctionTemplate>());
+    Constructor()->SetClassName(NanSymbol("DataSink"));
+    Constructor()->InstanceTemplate()->SetInternalFieldCount(1);
+
+    auto sig0 = NanNew<Signature>(Constructor());
+
+    EOS_SET_METHOD(Constructor(), "write", DataSink, Write, sig0);
+    EOS_SET_METHOD(Constructor(), "end", DataSink, End, sig0);
+    EOS_SET_METHOD(Constructor(), "abort", DataSink, Abort, sig0);
+}
+
+DataSink::DataSink()
+    : drain_(nullptr)
+    , reader_(nullptr)
+    , queuedBytes_(0)
+    , ended_(false)
+    , aborted_(false)
+    , cancelled_(false)
+    , closed_(true)
+    , waitingForDrain_(false)
+{
+    EOS_DEBUG_METHOD();
+
+    uv_mutex_init(&mutex_);
+}
+
+DataSink::~DataSink() {
+    EOS_DEBUG_METHOD();
+
+    assert(closed_ && !drain_);
+
+    for (auto it = chunks_.begin(); it != chunks_.end(); ++it)
+        delete[] it->data;
+
+    uv_mutex_destroy(&mutex_);
+}
+
+Handle<Object> DataSink::New() {
+    auto sink = new(nothrow) DataSink();
+    if (!sink)
+        return Handle<Object>();
+
+    auto handle = Constructor()->GetFunction()->NewInstance();
+    sink->Wrap(handle);
+    return handle;
+}
+
+void DataSink::Open(uv_loop_t* loop) {
+    EOS_DEBUG_METHOD();
+
+    assert(!drain_);
+
+    drain_ = new uv_async_t();
+    drain_->data = this;
+    uv_async_init(loop, drain_, &DrainCallback);
+
+    closed_ = false;
+}
+
+void DataSink::Close() {
+    EOS_DEBUG_METHOD();
+
+    uv_mutex_lock(&mutex_);
+    closed_ = true;
+    uv_mutex_unlock(&mutex_);
+
+    reader_ = nullptr;
+
+    if (drain_) {
+        uv_close(reinterpret_cast<uv_handle_t*>(drain_), &ClosedCallback);
+        drain_ = nullptr;
+    }
+}
+
+void DataSink::ClosedCallback(uv_handle_t* handle) {
+    delete reinterpret_cast<uv_async_t*>(handle);
+}
+
+NAN_METHOD(DataSink::Write) {
+    EOS_DEBUG_METHOD();
+
+    if (args.Length() < 1 || !JSBuffer::HasInstance(args[0]))
+        return NanThrowTypeError("DataSink::Write() requires a Buffer");
+
+    SQLPOINTER data;
+    SQLLEN length;
+    if (auto msg = JSBuffer::Unwrap(args[0].As<Object>(), data, length))
+        return NanThrowError(msg);
+
+    uv_mutex_lock(&mutex_);
+
+    if (closed_ || ended_ || aborted_ || cancelled_) {
+        uv_mutex_unlock(&mutex_);
+        NanReturnValue(NanFalse());
+    }
+
+    if (length > 0) {
+        Chunk chunk = { new(nothrow) char[length], length };
+        if (!chunk.data) {
+            uv_mutex_unlock(&mutex_);
+            return NanThrowError("Out of memory copying the chunk");
+        }
+
+        memcpy(chunk.data, data, length);
+        chunks_.push_back(chunk);
+        queuedBytes_ += length;
+    }
+
+    bool full = queuedBytes_ >= HighWaterMark;
+    if (full)
+        waitingForDrain_ = true;
+
+    uv_mutex_unlock(&mutex_);
+
+    if (length > 0)
+        Notify();
+
+    NanReturnValue(NanNew<Boolean>(!full));
+}
+
+NAN_METHOD(DataSink::End) {
+    EOS_DEBUG_METHOD();
+
+    uv_mutex_lock(&mutex_);
+    ended_ = true;
+    uv_mutex_unlock(&mutex_);
+
+    Notify();
+
+    NanReturnUndefined();
+}
+
+NAN_METHOD(DataSink::Abort) {
+    EOS_DEBUG_METHOD();
+
+    uv_mutex_lock(&mutex_);
+    aborted_ = true;
+    uv_mutex_unlock(&mutex_);
+
+    Notify();
+
+    NanReturnUndefined();
+}
+
+DataSink::PopResult DataSink::Pop(Chunk& chunk) {
+    uv_mutex_lock(&mutex_);
+
+    PopResult result;
+    if (cancelled_) {
+        result = Cancelled;
+    } else if (aborted_) {
+        result = Aborted;
+    } else if (!chunks_.empty()) {
+        chunk = chunks_.front();
+        chunks_.pop_front();
+        result = Popped;
+    } else {
+        result = ended_ ? Ended : Empty;
+    }
+
+    uv_mutex_unlock(&mutex_);
+    return result;
+}
+
+bool DataSink::Wait(Reader* reader) {
+    assert(!reader_);
+
+    uv_mutex_lock(&mutex_);
+    bool empty = chunks_.empty() && !ended_ && !aborted_ && !cancelled_;
+    uv_mutex_unlock(&mutex_);
+
+    if (empty)
+        reader_ = reader;
+    return empty;
+}
+
+void DataSink::Cancel() {
+    uv_mutex_lock(&mutex_);
+    cancelled_ = true;
+    uv_mutex_unlock(&mutex_);
+}
+
+void DataSink::Notify() {
+    if (auto reader = reader_) {
+        reader_ = nullptr;
+        reader->DataAvailable();
+    }
+}
+
+void DataSink::Release(Chunk& chunk) {
+    delete[] chunk.data;
+
+    uv_mutex_lock(&mutex_);
+
+    queuedBytes_ -= chunk.length;
+    if (waitingForDrain_ && queuedBytes_ <= HighWaterMark / 2 && !closed_) {
+        waitingForDrain_ = false;
+        uv_async_send(drain_);
+    }
+
+    uv_mutex_unlock(&mutex_);
+
+    chunk.data = nullptr;
+}
+
+#if defined(NODE_12)
+void DataSink::DrainCallback(uv_async_t* async) {
+#else
+void DataSink::DrainCallback(uv_async_t* async, int) {
+#endif
+    EOS_DEBUG_METHOD();
+
+    NanScope();
+
+    auto sink = static_cast<DataSink*>(async->data);
+    auto handle = NanObjectWrapHandle(sink);
+    auto ondrain = handle->Get(NanSymbol("ondrain"));
+
+    if (ondrain->IsFunction())
+        NanMakeCallback(handle, ondrain.As<Function>(), 0, nullptr);
+}
+
+namespace { ClassInitializer<DataSink> init; } 
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "eos.hpp"
+
+#include <deque>
+
+namespace Eos {
+    // A queue of chunks of data written from JavaScript, and read by a worker thread
+    // which sends them with SQLPutData. Created by Statement.putDataStream().
+    //
+    // write() copies each chunk into the queue, and returns false when the queue is
+    // full. When the worker has drained the queue below half of that, ondrain() is called
+    // on the main thread (via a uv_async_t).
+    //
+    // The worker never waits for chunks: it sends those which are queued, and when the 
+    // queue is empty its reader waits, on the main thread, to be told that there are more,
+    // so that a slow producer does not tie up the worker thread.
+    struct DataSink: ObjectWrap {
+        DataSink();
+        ~DataSink();
+
+        static void Init(Handle<Object> exports);
+        static Handle<Object> New();
+
+        static DataSink* Unwrap(Handle<Object> obj) { 
+            return ObjectWrap::Unwrap<DataSink>(obj);
+        }
+
+        NAN_METHOD(Write);
+        NAN_METHOD(End);
+        NAN_METHOD(Abort);
+
+        static Handle<FunctionTemplate> Constructor() { return NanNew(constructor_); }
+
+        // The number of queued bytes at which write() starts returning false.
+        enum { HighWaterMark = 256 * 1024 };
+
+        struct Chunk {
+            char* data;
+            SQLLEN length;
+        };
+
+        enum PopResult { Popped, Empty, Ended, Aborted, Cancelled };
+
+        // Told on the main thread that a sink it was waiting on has a chunk, or has been 
+        // ended or aborted.
+        struct Reader {
+            virtual void DataAvailable() = 0;
+        };
+
+        // Main thread: starts and stops accepting chunks for the worker. Chunks written 
+        // after Close() are discarded. ondrain() is called on the given loop.
+        void Open(uv_loop_t* loop);
+        void Close();
+
+        // Worker thread: takes the next chunk, if one is queued. Returns Empty if there is
+        // none yet, and Ended once the stream has ended and every chunk has been taken.
+        PopResult Pop(Chunk& chunk);
+
+        // Main thread: returns false if Pop() would not return Empty. Otherwise, returns 
+        // true and calls reader->DataAvailable() once that changes.
+        bool Wait(Reader* reader);
+
+        // Watchdog thread: the operation reading the sink has timed out. Pop() returns 
+        // Cancelled from now on, and write() returns false.
+        void Cancel();
+
+        // Worker thread: frees a chunk returned by Pop(), and wakes the main thread 
+        // if it is waiting for the queue to drain.
+        void Release(Chunk& chunk);
+
+    private:
+#if defined(NODE_12)
+        static void DrainCallback(uv_async_t* async);
+#else
+        static void DrainCallback(uv_async_t* async, int status);
+#endif
+        static void ClosedCallback(uv_handle_t* handle);
+
+        // Main thread: wakes the reader, if it is waiting.
+        void Notify();
+
+        uv_mutex_t mutex_;
+        uv_async_t* drain_;
+        Reader* reader_;
+        std::deque<Chunk> chunks_;
+        SQLLEN queuedBytes_;
+        bool ended_, aborted_, cancelled_, closed_, waitingForDrain_;
+
+        static Persistent<FunctionTemplate> constructor_;
+    };
+}
@@ -0,0 +1,68 @@
+#include "decoder.hpp"
+
+namespace Eos {
+    namespace {
+        template <typename T>
+        Handle<Value> DecodeNumber(SQLPOINTER buffer, SQLLEN, SQLLEN) {
+            return NanNew<Number>(*reinterpret_cast<T*>(buffer));
+        }
+
+        Handle<Value> DecodeBit(SQLPOINTER buffer, SQLLEN, SQLLEN) {
+            return *reinterpret_cast<SQLCHAR*>(buffer) ? NanTrue() : NanFalse();
+        }
+
+        Handle<Value> DecodeChar(SQLPOINTER buffer, SQLLEN indicator, SQLLEN bufferLength) {
+            if (indicator == SQL_NO_TOTAL || indicator > bufferLength)
+                indicator = bufferLength;
+
+            // Subtract one character iff buffer full, due to null terminator. The buffer length can be
+            // zero if the string was empty.
+            if (indicator > 0 && indicator == bufferLength)
+                --indicator;
+            return NanNew<String>(reinterpret_cast<const char*>(buffer), indicator);
+        }
+
+        Handle<Value> DecodeWChar(SQLPOINTER buffer, SQLLEN indicator, SQLLEN bufferLength) {
+            if (indicator == SQL_NO_TOTAL || indicator > bufferLength)
+                indicator = bufferLength;
+
+            // Subtract one character iff buffer full, due to null terminator. The indicator can be zero
+            // if the string was empty.
+            assert(indicator % sizeof(SQLWCHAR) == 0);
+            if (indicator > 0 && indicator == bufferLength)
+                indicator -= sizeof(SQLWCHAR);
+            return StringFromTChar(reinterpret_cast<const SQLWCHAR*>(buffer), indicator / 2);
+        }
+
+        template <bool AsNumber>
+        Handle<Value> DecodeTimestamp(SQLPOINTER buffer, SQLLEN, SQLLEN) {
+            auto& ts = *reinterpret_cast<SQL_TIMESTAMP_STRUCT*>(buffer);
+            if (AsNumber)
+                return NanNew<Number>(SQLTimeToV8Time(ts));
+            return NanNew<Date>(SQLTimeToV8Time(ts));
+        }
+
+        Handle<Value> DecodeUnknown(SQLPOINTER, SQLLEN, SQLLEN) {
+            return NanUndefined();
+        }
+    }
+
+    Decoder GetDecoder(SQLSMALLINT cType, int options) {
+        switch(cType) {
+        case SQL_C_SLONG: return &DecodeNumber<SQLINTEGER>;
+        case SQL_C_SSHORT: return &DecodeNumber<SQLSMALLINT>;
+        case SQL_C_DOUBLE: return &DecodeNumber<SQLDOUBLE>;
+        case SQL_C_BIT: return &DecodeBit;
+        case SQL_C_CHAR: return &DecodeChar;
+        case SQL_C_WCHAR: return &DecodeWChar;
+
+        case SQL_C_TYPE_TIMESTAMP: 
+            if (options & ConvertTimestampAsNumber)
+                return &DecodeTimestamp<true>;
+            return &DecodeTimestamp<false>;
+
+        default: 
+            return &DecodeUnknown;
+        }
+    }
+}
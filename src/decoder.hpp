@@ -0,0 +1,14 @@
+#pragma once
+
+#include "eos.hpp"
+
+namespace Eos {
+    // A Decoder converts a single value of a particular C type into a JavaScript value.
+    // Columns pick their decoder once (when they are bound or described), so that 
+    // converting each value does not need to look at the C type again.
+    typedef Handle<Value> (*Decoder)(SQLPOINTER buffer, SQLLEN indicator, SQLLEN bufferLength);
+
+    // Returns the decoder for the given C type and combination of ConvertOptions flags.
+    // Never returns nullptr: unsupported C types get a decoder which returns undefined.
+    Decoder GetDecoder(SQLSMALLINT cType, int options = ConvertDefault);
+}
@@ -1,5 +1,8 @@
 #include "env.hpp"
 #include "conn.hpp"
+#include "pool.hpp"
+
+#include <set>
 
 using namespace Eos;
 
@@ -10,16 +13,62 @@ void Eos::Environment::Init(Handle<Object> exports) {
     auto sig0 = NanNew<Signature>(Constructor());
 
     EOS_SET_METHOD(Constructor(), "newConnection", Environment, NewConnection, sig0);
+    EOS_SET_METHOD(Constructor(), "openMany", Environment, OpenMany, sig0);
     EOS_SET_METHOD(Constructor(), "dataSources", Environment, DataSources, sig0);
     EOS_SET_METHOD(Constructor(), "drivers", Environment, Drivers, sig0);
+    EOS_SET_METHOD(Constructor(), "poolStats", Environment, PoolStats, sig0);
+    EOS_SET_METHOD(Constructor(), "connectionStats", Environment, ConnectionStats, sig0);
+    EOS_SET_GETTER(Constructor(), "workerThreads", Environment, GetWorkerThreads);
+    EOS_SET_ACCESSOR(Constructor(), "coalesceCallbacks", Environment, GetCoalesceCallbacks, SetCoalesceCallbacks);
+    EOS_SET_ACCESSOR(Constructor(), "asyncPolling", Environment, GetAsyncPolling, SetAsyncPolling);
+    EOS_SET_GETTER(Constructor(), "connectionPooling", Environment, GetConnectionPooling);
+    EOS_SET_ACCESSOR(Constructor(), "connectionPoolMatch", Environment, GetConnectionPoolMatch, SetConnectionPoolMatch);
     
     exports->Set(NanSymbol("Environment"), Constructor()->GetFunction() IF_NODE_12(EOS_COMMA ReadOnly));
 }
 
-Eos::Environment::Environment(SQLHENV hEnv) 
+Eos::Environment::Environment(SQLHENV hEnv, SQLUINTEGER connectionPooling) 
     : EosHandle(SQL_HANDLE_ENV, hEnv EOS_ASYNC_ONLY_ARG(nullptr)) 
+    , connectionPooling_(connectionPooling)
 {
     EOS_DEBUG_METHOD();
+
+    connectStats_.fresh = connectStats_.reused = 0;
+}
+
+namespace {
+    bool ParseConnectionPooling(Handle<Value> value, SQLUINTEGER& result) {
+        if (value->IsFalse())
+            result = SQL_CP_OFF;
+        else if (value->Equals(NanNew<String>("driver")))
+            result = SQL_CP_ONE_PER_DRIVER;
+        else if (value->Equals(NanNew<String>("environment")))
+            result = SQL_CP_ONE_PER_HENV;
+        else
+            return false;
+        return true;
+    }
+
+    bool ParseConnectionPoolMatch(Handle<Value> value, SQLUINTEGER& result) {
+        if (value->Equals(NanNew<String>("strict")))
+            result = SQL_CP_STRICT_MATCH;
+        else if (value->Equals(NanNew<String>("relaxed")))
+            result = SQL_CP_RELAXED_MATCH;
+        else
+            return false;
+        return true;
+    }
+
+    // The driver connection handles (SQL_DRIVER_HDBC) of connections which were disconnected
+    // while the driver manager was pooling connections, and so may be handed out again. The 
+    // pool can be shared between environments, so this is too.
+    //
+    // The driver manager does not say when it closes an idle pooled connection, so entries
+    // can go stale, and a new connection whose handle happens to have the same address is
+    // then counted as reused. The counts are only an estimate, and the set is cleared when 
+    // it reaches MaxPooledConnections rather than growing without limit.
+    std::set<SQLULEN> pooledConnections;
+    const std::size_t MaxPooledConnections = 4096;
 }
 
 NAN_METHOD(Eos::Environment::New) {
@@ -27,8 +76,52 @@ NAN_METHOD(Eos::Environment::New) {
 
     NanScope();
 
-    if (!args.IsConstructCall())
-        NanReturnValue(Constructor()->GetFunction()->NewInstance());
+    if (!args.IsConstructCall()) {
+        Handle<Value> argv[1] = { args[0] };
+        NanReturnValue(Constructor()->GetFunction()->NewInstance(args.Length() > 0 ? 1 : 0, argv));
+    }
+
+    unsigned int workerThreads = WorkerPool::DefaultMaxThreads;
+    bool coalesceCallbacks = false, asyncPolling = false;
+    bool setConnectionPooling = false, setConnectionPoolMatch = false;
+    SQLUINTEGER connectionPooling = SQL_CP_OFF, connectionPoolMatch = SQL_CP_STRICT_MATCH;
+
+    if (args.Length() > 0 && !args[0]->IsUndefined()) {
+        if (!args[0]->IsObject())
+            return NanThrowTypeError("The options argument must be an object");
+
+        auto value = args[0].As<Object>()->Get(NanSymbol("workerThreads"));
+        if (!value->IsUndefined()) {
+            if (!value->IsUint32() || value->Uint32Value() < 1 || value->Uint32Value() > WorkerPool::MaxMaxThreads)
+                return NanThrowRangeError("workerThreads must be an integer between 1 and 256");
+            workerThreads = value->Uint32Value();
+        }
+
+        coalesceCallbacks = args[0].As<Object>()->Get(NanSymbol("coalesceCallbacks"))->BooleanValue();
+        asyncPolling = args[0].As<Object>()->Get(NanSymbol("asyncPolling"))->BooleanValue();
+
+        value = args[0].As<Object>()->Get(NanSymbol("connectionPooling"));
+        if (!value->IsUndefined()) {
+            if (!ParseConnectionPooling(value, connectionPooling))
+                return NanThrowRangeError("connectionPooling must be false, 'driver' or 'environment'");
+            setConnectionPooling = true;
+        }
+
+        value = args[0].As<Object>()->Get(NanSymbol("connectionPoolMatch"));
+        if (!value->IsUndefined()) {
+            if (!ParseConnectionPoolMatch(value, connectionPoolMatch))
+                return NanThrowRangeError("connectionPoolMatch must be 'strict' or 'relaxed'");
+            setConnectionPoolMatch = true;
+        }
+    }
+
+    // Connection pooling is a process-wide setting, which the driver manager reads when each
+    // environment is allocated.
+    if (setConnectionPooling) {
+        auto ret = SQLSetEnvAttr(SQL_NULL_HANDLE, SQL_ATTR_CONNECTION_POOLING, (SQLPOINTER)(uintptr_t)connectionPooling, SQL_IS_UINTEGER);
+        if (!SQL_SUCCEEDED(ret))
+            return NanThrowError("Unable to set the connection pooling mode");
+    }
 
     SQLHENV hEnv;
     auto ret = SQLAllocHandle(SQL_HANDLE_ENV, SQL_NULL_HANDLE, &hEnv);
@@ -42,24 +135,33 @@ NAN_METHOD(Eos::Environment::New) {
         return NanThrowError(exception);
     }
 
-    (new Environment(hEnv))->Wrap(args.Holder());
-    NanReturnValue(args.Holder());
-}
-
-namespace {
-    _NAN_METHOD_RETURN_TYPE ThrowClosed() {
-        return NanThrowError(OdbcError("The environment has been closed."));
+    if (setConnectionPoolMatch) {
+        ret = SQLSetEnvAttr(hEnv, SQL_ATTR_CP_MATCH, (SQLPOINTER)(uintptr_t)connectionPoolMatch, SQL_IS_UINTEGER);
+        if (!SQL_SUCCEEDED(ret)) {
+            auto exception = Eos::GetLastError(SQL_HANDLE_ENV, hEnv);
+            SQLFreeHandle(SQL_HANDLE_ENV, hEnv);
+            return NanThrowError(exception);
+        }
     }
-}
 
-NAN_METHOD(Eos::Environment::NewConnection) {
-    EOS_DEBUG_METHOD();
+    // The pooling mode may also have been turned on by the driver manager's configuration,
+    // or by an earlier environment.
+    if (!SQL_SUCCEEDED(SQLGetEnvAttr(hEnv, SQL_ATTR_CONNECTION_POOLING, &connectionPooling, SQL_IS_UINTEGER, nullptr)))
+        connectionPooling = setConnectionPooling ? connectionPooling : SQL_CP_OFF;
+
+    auto pool = WorkerPool::New(EventLoop(), workerThreads);
+    if (!pool) {
+        SQLFreeHandle(SQL_HANDLE_ENV, hEnv);
+        return NanThrowError("Unable to allocate the worker pool or start its first thread");
+    }
 
-    if (!IsValid())
-        return ThrowClosed();
+    pool->SetCoalesceCallbacks(coalesceCallbacks);
+    pool->SetAsyncPolling(asyncPolling);
 
-    Handle<Value> argv[1] = { NanObjectWrapHandle(this) };
-    EosMethodReturnValue(Connection::Constructor()->GetFunction()->NewInstance(1, argv));
+    auto env = new Environment(hEnv, connectionPooling);
+    env->SetPool(pool, 0);
+    env->Wrap(args.Holder());
+    NanReturnValue(args.Holder());
 }
 
 NAN_METHOD(Eos::Environment::DataSources) {
@@ -156,6 +258,130 @@ NAN_METHOD(Eos::Environment::Drivers) {
     }
 }
 
+namespace {
+    Handle<Object> LaneStatsObject(const WorkerPool::LaneStats& stats) {
+        auto obj = NanNew<Object>();
+        obj->Set(NanSymbol("queued"), NanNew<Number>(stats.queued));
+        obj->Set(NanSymbol("submitted"), NanNew<Number>(static_cast<double>(stats.submitted)));
+        obj->Set(NanSymbol("started"), NanNew<Number>(static_cast<double>(stats.started)));
+
+        // Nanoseconds to milliseconds
+        auto averageWait = stats.started ? static_cast<double>(stats.totalWait) / stats.started : 0.0;
+        obj->Set(NanSymbol("averageWait"), NanNew<Number>(averageWait / 1e6));
+        obj->Set(NanSymbol("maxWait"), NanNew<Number>(static_cast<double>(stats.maxWait) / 1e6));
+        return obj;
+    }
+}
+
+NAN_METHOD(Eos::Environment::PoolStats) {
+    EOS_DEBUG_METHOD();
+
+    WorkerPool::LaneStats stats[WorkerPool::LaneCount];
+    Pool()->GetLaneStats(stats);
+
+    auto result = NanNew<Object>();
+    result->Set(NanSymbol("threads"), NanNew<Integer>(static_cast<int32_t>(Pool()->ThreadCount())));
+    result->Set(NanSymbol("interactive"), LaneStatsObject(stats[WorkerPool::LaneInteractive]));
+    result->Set(NanSymbol("batch"), LaneStatsObject(stats[WorkerPool::LaneBatch]));
+
+    auto& batchStats = Pool()->GetBatchStats();
+    auto callbackBatches = NanNew<Object>();
+    callbackBatches->Set(NanSymbol("count"), NanNew<Number>(static_cast<double>(batchStats.batches)));
+    callbackBatches->Set(NanSymbol("callbacks"), NanNew<Number>(static_cast<double>(batchStats.callbacks)));
+    callbackBatches->Set(NanSymbol("largest"), NanNew<Number>(batchStats.largest));
+    result->Set(NanSymbol("callbackBatches"), callbackBatches);
+
+    WorkerPool::PollerStats pollerStats;
+    Pool()->GetPollerStats(pollerStats);
+    auto polled = NanNew<Object>();
+    polled->Set(NanSymbol("started"), NanNew<Number>(static_cast<double>(pollerStats.started)));
+    polled->Set(NanSymbol("completed"), NanNew<Number>(static_cast<double>(pollerStats.completed)));
+    polled->Set(NanSymbol("polls"), NanNew<Number>(static_cast<double>(pollerStats.polls)));
+    result->Set(NanSymbol("polled"), polled);
+
+    EosMethodReturnValue(result);
+}
+
+NAN_METHOD(Eos::Environment::ConnectionStats) {
+    EOS_DEBUG_METHOD();
+
+    auto result = NanNew<Object>();
+    result->Set(NanSymbol("fresh"), NanNew<Number>(static_cast<double>(connectStats_.fresh)));
+    result->Set(NanSymbol("reused"), NanNew<Number>(static_cast<double>(connectStats_.reused)));
+
+    EosMethodReturnValue(result);
+}
+
+void Eos::Environment::ConnectionOpened(SQLULEN driverConnection) {
+    if (connectionPooling_ != SQL_CP_OFF && driverConnection && pooledConnections.erase(driverConnection))
+        connectStats_.reused++;
+    else
+        connectStats_.fresh++;
+}
+
+void Eos::Environment::ConnectionClosed(SQLULEN driverConnection) {
+    if (connectionPooling_ == SQL_CP_OFF || !driverConnection)
+        return;
+
+    if (pooledConnections.size() >= MaxPooledConnections)
+        pooledConnections.clear();
+    pooledConnections.insert(driverConnection);
+}
+
+NAN_GETTER(Eos::Environment::GetWorkerThreads) const {
+    EosMethodReturnValue(NanNew<Integer>(static_cast<int32_t>(Pool()->MaxThreads())));
+}
+
+NAN_GETTER(Eos::Environment::GetCoalesceCallbacks) const {
+    EosMethodReturnValue(NanNew<Boolean>(Pool()->CoalesceCallbacks()));
+}
+
+NAN_SETTER(Eos::Environment::SetCoalesceCallbacks) {
+    Pool()->SetCoalesceCallbacks(value->BooleanValue());
+}
+
+NAN_GETTER(Eos::Environment::GetAsyncPolling) const {
+    EosMethodReturnValue(NanNew<Boolean>(Pool()->AsyncPolling()));
+}
+
+NAN_SETTER(Eos::Environment::SetAsyncPolling) {
+    Pool()->SetAsyncPolling(value->BooleanValue());
+}
+
+NAN_GETTER(Eos::Environment::GetConnectionPooling) const {
+    switch (connectionPooling_) {
+    case SQL_CP_OFF:
+        EosMethodReturnValue(NanFalse());
+    case SQL_CP_ONE_PER_DRIVER:
+        EosMethodReturnValue(NanNew<String>("driver"));
+    case SQL_CP_ONE_PER_HENV:
+        EosMethodReturnValue(NanNew<String>("environment"));
+    default:
+        EosMethodReturnValue(NanTrue());
+    }
+}
+
+NAN_GETTER(Eos::Environment::GetConnectionPoolMatch) const {
+    SQLUINTEGER match;
+    auto ret = SQLGetEnvAttr(GetHandle(), SQL_ATTR_CP_MATCH, &match, SQL_IS_UINTEGER, nullptr);
+    if (!SQL_SUCCEEDED(ret))
+        return NanThrowError(Eos::GetLastError(SQL_HANDLE_ENV, GetHandle()));
+
+    EosMethodReturnValue(NanNew<String>(match == SQL_CP_RELAXED_MATCH ? "relaxed" : "strict"));
+}
+
+NAN_SETTER(Eos::Environment::SetConnectionPoolMatch) {
+    SQLUINTEGER match;
+    if (!ParseConnectionPoolMatch(value, match)) {
+        NanThrowRangeError("connectionPoolMatch must be 'strict' or 'relaxed'");
+        return;
+    }
+
+    auto ret = SQLSetEnvAttr(GetHandle(), SQL_ATTR_CP_MATCH, (SQLPOINTER)(uintptr_t)match, SQL_IS_UINTEGER);
+    if (!SQL_SUCCEEDED(ret))
+        NanThrowError(GetLastError());
+}
+
 Eos::Environment::~Environment() {
     EOS_DEBUG_METHOD();
 }
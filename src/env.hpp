@@ -5,23 +5,49 @@
 
 namespace Eos {
     struct Environment: EosHandle {
-        Environment(SQLHENV hEnv);
+        Environment(SQLHENV hEnv, SQLUINTEGER connectionPooling);
         ~Environment();
 
         static void Init(Handle<Object> exports);
         static NAN_METHOD(New);
 
+        static const int HandleType = SQL_HANDLE_ENV;
+
     public:
         // JS methods
         NAN_METHOD(NewConnection);
+        NAN_METHOD(OpenMany);
         NAN_METHOD(DataSources);
         NAN_METHOD(Drivers);
+        NAN_METHOD(PoolStats);
+        NAN_METHOD(ConnectionStats);
+
+        NAN_GETTER(GetWorkerThreads) const;
+        NAN_GETTER(GetCoalesceCallbacks) const;
+        NAN_SETTER(SetCoalesceCallbacks);
+        NAN_GETTER(GetAsyncPolling) const;
+        NAN_SETTER(SetAsyncPolling);
+        NAN_GETTER(GetConnectionPooling) const;
+        NAN_GETTER(GetConnectionPoolMatch) const;
+        NAN_SETTER(SetConnectionPoolMatch);
 
     public:
         // Non-JS methods
         static Handle<FunctionTemplate> Constructor() { return NanNew(constructor_); }
 
+        // Called by connections when they connect and disconnect, with the driver's connection
+        // handle (SQL_DRIVER_HDBC). If the driver manager is pooling connections, a connection 
+        // which gets a driver handle that was previously disconnected is counted as reused.
+        void ConnectionOpened(SQLULEN driverConnection);
+        void ConnectionClosed(SQLULEN driverConnection);
+
     private:
+        SQLUINTEGER connectionPooling_;
+        
+        struct {
+            uint64_t fresh, reused;
+        } connectStats_;
+
         static Persistent<FunctionTemplate> constructor_;
     };
 }
\ No newline at end of file
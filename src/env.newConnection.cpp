@@ -0,0 +1,79 @@
+#include "env.hpp"
+#include "conn.hpp"
+
+using namespace Eos;
+
+namespace Eos {
+    struct NewConnectionOperation : Operation<Environment, NewConnectionOperation> {
+        // SQLAllocHandle cannot be run asynchronously.
+        enum { Pollable = false, AsyncCapable = false };
+
+        NewConnectionOperation() : hDbc_(SQL_NULL_HANDLE) {
+            EOS_DEBUG_METHOD();
+        }
+
+        static EOS_OPERATION_CONSTRUCTOR(New, Environment) {
+            EOS_DEBUG_METHOD();
+
+            if (args.Length() < 2)
+                return NanError("Too few arguments");
+
+            (new NewConnectionOperation())->Wrap(args.Holder());
+
+            EOS_OPERATION_CONSTRUCTOR_RETURN();
+        }
+
+        void CallbackOverride(SQLRETURN ret) {
+            EOS_DEBUG_METHOD();
+
+            if (!SQL_SUCCEEDED(ret))
+                return CallbackErrorOverride(ret);
+
+            // If Connection::New throws, it frees the handle itself.
+            TryCatch tc;
+            Handle<Value> ctorArgs[] = { NanObjectWrapHandle(Owner()), NanNew<External>(hDbc_) };
+            auto conn = Connection::Constructor()->GetFunction()->NewInstance(2, ctorArgs);
+            if (conn.IsEmpty()) {
+                Handle<Value> argv[] = { tc.Exception() };
+                return MakeCallback(argv);
+            }
+
+            Handle<Value> argv[] = { NanUndefined(), conn };
+            MakeCallback(argv);
+        }
+
+        static const char* Name() { return "NewConnectionOperation"; }
+
+    protected:
+        SQLRETURN CallOverride() {
+            EOS_DEBUG_METHOD();
+
+            return SQLAllocHandle(
+                SQL_HANDLE_DBC,
+                Owner()->GetHandle(),
+                &hDbc_);
+        }
+
+    private:
+        SQLHDBC hDbc_;
+    };
+}
+
+NAN_METHOD(Environment::NewConnection) {
+    EOS_DEBUG_METHOD();
+
+    if (!IsValid())
+        return NanThrowError(OdbcError("The environment has been closed."));
+
+    // With a callback, the handle is allocated on a worker thread.
+    if (args.Length() > 0 && args[0]->IsFunction()) {
+        Handle<Value> argv[] = { NanObjectWrapHandle(this), args[0] };
+        return Begin<NewConnectionOperation>(argv);
+    }
+
+    Handle<Value> argv[1] = { NanObjectWrapHandle(this) };
+    EosMethodReturnValue(Connection::Constructor()->GetFunction()->NewInstance(1, argv));
+}
+
+template<> Persistent<FunctionTemplate> Operation<Environment, NewConnectionOperation>::constructor_ = Persistent<FunctionTemplate>();
+namespace { ClassInitializer<NewConnectionOperation> ci; }
@@ -0,0 +1,221 @@
+#include "env.hpp"
+#include "conn.hpp"
+
+using namespace Eos;
+
+namespace {
+    // Opens count connections with the same connection string, at most parallelism at a time,
+    // each on the next worker thread, so that the logins overlap instead of queueing behind
+    // each other on the environment's thread.
+    struct OpenManyBatch {
+        OpenManyBatch(Environment* env, Handle<Value> connectionString, Handle<Function> callback, unsigned int count, unsigned int parallelism)
+            : connectionString(connectionString)
+            , env_(env)
+            , count_(count)
+            , parallelism_(parallelism)
+            , started_(0)
+            , finished_(0)
+        {
+            env_->Ref();
+            NanAssignPersistent(callback_, callback);
+            NanAssignPersistent(connections_, NanNew<Array>());
+            NanAssignPersistent(errors_, NanNew<Array>());
+        }
+
+        ~OpenManyBatch() {
+            NanDisposePersistent(callback_);
+            NanDisposePersistent(connections_);
+            NanDisposePersistent(errors_);
+            env_->Unref();
+        }
+
+        // Starts tasks until parallelism are running. Returns false if no more can be started 
+        // because the environment has been freed or memory has run out.
+        bool Start();
+        void TaskCompleted(SQLHDBC hDbc, unsigned int affinity, Handle<Value> error);
+
+        bool Running() const { return started_ > finished_; }
+        SQLHENV EnvironmentHandle() const { return env_->GetHandle(); }
+
+        // Read, but never written, by the worker threads.
+        WStringValue connectionString;
+
+    private:
+        void Finish();
+
+        Environment* env_;
+        Persistent<Function> callback_;
+        Persistent<Array> connections_, errors_;
+        unsigned int count_, parallelism_, started_, finished_;
+    };
+
+    // Allocates a connection handle and connects it, on a worker thread. The errors are read
+    // from the handles on the main thread, as for operations.
+    struct OpenManyTask : WorkerPool::Task {
+        OpenManyTask(OpenManyBatch* batch, unsigned int affinity)
+            : batch_(batch)
+            , affinity_(affinity)
+            , hDbc_(SQL_NULL_HANDLE)
+            , ret_(SQL_SUCCESS)
+            , allocated_(false)
+        { }
+
+        void Run() {
+            ret_ = SQLAllocHandle(SQL_HANDLE_DBC, batch_->EnvironmentHandle(), &hDbc_);
+            if (!SQL_SUCCEEDED(ret_))
+                return;
+
+            allocated_ = true;
+
+            SQLSMALLINT cchCompleted; // Not used
+            ret_ = SQLDriverConnectW(
+                hDbc_,
+                SQL_NULL_HANDLE,
+                *batch_->connectionString, batch_->connectionString.length(),
+                nullptr, 0, &cchCompleted,
+                SQL_DRIVER_NOPROMPT);
+        }
+
+        unsigned int Affinity() const { return affinity_; }
+
+        void Completed() {
+            NanScope();
+
+            if (SQL_SUCCEEDED(ret_)) {
+                batch_->TaskCompleted(hDbc_, affinity_, NanUndefined());
+            } else if (allocated_) {
+                auto error = Eos::GetLastError(SQL_HANDLE_DBC, hDbc_);
+                SQLFreeHandle(SQL_HANDLE_DBC, hDbc_);
+                batch_->TaskCompleted(SQL_NULL_HANDLE, affinity_, error);
+            } else {
+                batch_->TaskCompleted(SQL_NULL_HANDLE, affinity_, Eos::GetLastError(SQL_HANDLE_ENV, batch_->EnvironmentHandle()));
+            }
+
+            delete this;
+        }
+
+    private:
+        OpenManyBatch* batch_;
+        unsigned int affinity_;
+        SQLHDBC hDbc_;
+        SQLRETURN ret_;
+        bool allocated_;
+    };
+
+    bool OpenManyBatch::Start() {
+        if (!env_->IsValid())
+            return false;
+
+        auto pool = env_->Pool();
+
+        while (started_ < count_ && started_ - finished_ < parallelism_) {
+            auto task = new(nothrow) OpenManyTask(this, pool->NextAffinity());
+            if (!task)
+                return false;
+
+            // The task uses the environment handle on the worker thread, so it must not be 
+            // freed until the task has completed.
+            started_++;
+            env_->TaskStarted();
+            pool->Submit(task->Affinity(), env_->Priority(), task);
+        }
+
+        return true;
+    }
+
+    void OpenManyBatch::TaskCompleted(SQLHDBC hDbc, unsigned int affinity, Handle<Value> error) {
+        finished_++;
+        env_->TaskFinished();
+
+        if (hDbc) {
+            // If Connection::New throws, it frees the handle itself. The connection stays on
+            // the thread which connected it.
+            TryCatch tc;
+            Handle<Value> ctorArgs[] = { 
+                NanObjectWrapHandle(env_), 
+                NanNew<External>(hDbc), 
+                NanNew<Integer>(affinity) 
+            };
+            auto conn = Connection::Constructor()->GetFunction()->NewInstance(3, ctorArgs);
+            if (conn.IsEmpty()) {
+                error = tc.Exception();
+            } else {
+                ObjectWrap::Unwrap<Connection>(conn)->Connected();
+                auto connections = NanNew(connections_);
+                connections->Set(connections->Length(), conn);
+            }
+        }
+
+        if (!error->IsUndefined()) {
+            auto errors = NanNew(errors_);
+            errors->Set(errors->Length(), error);
+        }
+
+        if ((!Start() && !Running()) || finished_ == count_)
+            Finish();
+    }
+
+    void OpenManyBatch::Finish() {
+        auto connections = NanNew(connections_);
+        auto errors = NanNew(errors_);
+
+        // Connections which could not be started.
+        for (; started_ < count_; started_++)
+            errors->Set(errors->Length(), OdbcError(env_->IsValid() ? "Out of memory" : "The environment has been closed."));
+
+        // The connections which did open are reported even if some failed, so that they can
+        // be used or closed; err is only set if none did.
+        Handle<Value> argv[] = {
+            connections->Length() ? NanUndefined() : errors->Get(0),
+            connections,
+            errors
+        };
+
+        MakeCompletionCallback(NanObjectWrapHandle(env_), NanNew(callback_), 3, argv);
+        delete this;
+    }
+}
+
+NAN_METHOD(Environment::OpenMany) {
+    EOS_DEBUG_METHOD();
+
+    if (!IsValid())
+        return NanThrowError(OdbcError("The environment has been closed."));
+
+    if (args.Length() < 3)
+        return NanThrowError("Environment::OpenMany() requires a connection string, a count and a callback");
+
+    if (!args[0]->IsString())
+        return NanThrowTypeError("Connection string should be a string");
+
+    if (!args[1]->IsUint32() || args[1]->Uint32Value() < 1)
+        return NanThrowRangeError("The count must be a positive integer");
+
+    auto count = args[1]->Uint32Value();
+
+    // openMany(connectionString, count, [parallelism], callback)
+    auto parallelism = Pool()->MaxThreads();
+    auto callbackIndex = 2;
+    if (args.Length() > 3) {
+        if (!args[2]->IsUndefined()) {
+            if (!args[2]->IsUint32() || args[2]->Uint32Value() < 1)
+                return NanThrowRangeError("The parallelism must be a positive integer");
+            parallelism = args[2]->Uint32Value();
+        }
+        callbackIndex = 3;
+    }
+
+    if (!args[callbackIndex]->IsFunction())
+        return NanThrowTypeError("The last argument should be a callback function");
+
+    auto batch = new(nothrow) OpenManyBatch(this, args[0], args[callbackIndex].As<Function>(), count, parallelism);
+    if (!batch)
+        return NanThrowError(OdbcError("Out of memory"));
+
+    if (!batch->Start() && !batch->Running()) {
+        delete batch;
+        return NanThrowError(OdbcError("Out of memory"));
+    }
+
+    EosMethodReturnValue(NanUndefined());
+}
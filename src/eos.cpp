@@ -1,6 +1,7 @@
 #include "eos.hpp"
 #include "handle.hpp"
 #include "operation.hpp"
+#include "decoder.hpp"
 
 #include "uv.h"
 #include <ctime>
@@ -9,8 +10,6 @@
 
 int EosMethodDebugger::depth = 0;
 
-        uv_loop_t* default_loop;
-
 namespace Eos {
     ClassInitializerRecord rootClassInitializer = { 0 };
 
@@ -22,15 +21,33 @@ namespace Eos {
     }
 
     namespace {
-        Persistent<Function> nextTick;
-
         void InitError(Handle<Object> exports);
         void InitCallbacks();
+
+        // Function templates, OdbcError and the other persistent handles are process-wide
+        // statics belonging to the isolate which first loaded the module, so it cannot be
+        // used from any other isolate.
+        Isolate* moduleIsolate = nullptr;
+        uv_loop_t* moduleLoop = nullptr;
+    }
+
+    uv_loop_t* EventLoop() {
+        assert(moduleLoop);
+        return moduleLoop;
     }
 
     void Init(Handle<Object> exports) {
         EOS_DEBUG_METHOD();
 
+        auto isolate = Isolate::GetCurrent();
+        if (moduleIsolate && moduleIsolate != isolate) {
+            NanThrowError("eos can only be loaded by one isolate in each process");
+            return;
+        }
+
+        moduleIsolate = isolate;
+        moduleLoop = uv_default_loop();
+
         auto rec = &rootClassInitializer;
         while (rec = rec->next) {
             if (rec->Init)
@@ -42,6 +59,12 @@ namespace Eos {
         NODE_DEFINE_CONSTANT(exports, SQL_PARAM_INPUT_OUTPUT_STREAM);
         NODE_DEFINE_CONSTANT(exports, SQL_PARAM_OUTPUT);
         NODE_DEFINE_CONSTANT(exports, SQL_PARAM_OUTPUT_STREAM);
+
+        NODE_DEFINE_CONSTANT(exports, SQL_PARAM_SUCCESS);
+        NODE_DEFINE_CONSTANT(exports, SQL_PARAM_SUCCESS_WITH_INFO);
+        NODE_DEFINE_CONSTANT(exports, SQL_PARAM_ERROR);
+        NODE_DEFINE_CONSTANT(exports, SQL_PARAM_UNUSED);
+        NODE_DEFINE_CONSTANT(exports, SQL_PARAM_DIAG_UNAVAILABLE);
         
         NODE_DEFINE_CONSTANT(exports, SQL_CHAR);
         NODE_DEFINE_CONSTANT(exports, SQL_VARCHAR);
@@ -93,206 +116,16 @@ namespace Eos {
         int numberOfWaits = 0, numberOfCallbacks = 0;
 #endif
 
-        inline void CheckUV(int rc) {
-            assert(rc == 0);
-        }
-
-        int initCount = 0;
-        uv_async_t* async = nullptr;
-        uv_rwlock_t rwlock;
-        
-        struct Callback {
-            INotify* target;
-            Callback* next;
-
-            Callback(INotify* target) 
-                : target(target)
-                , next(0) 
-            { }
-        } *firstCallback = 0;
-        
-#ifdef NODE_12
-        void ProcessCallbackQueue(uv_async_t*);
-#else
-        void ProcessCallbackQueue(uv_async_t*, int);
-#endif
-
-        void InitialiseWaiter() {
-            EOS_DEBUG_METHOD_FMT(L"%i++", initCount);
-            assert(initCount >= 0);
-
-            if (initCount == 0) {
-                EOS_DEBUG_METHOD();
-
-                async = new uv_async_t();
-
-                auto loop = default_loop = uv_default_loop();
-                CheckUV(uv_rwlock_init(&rwlock));
-                CheckUV(uv_async_init(loop, async, &ProcessCallbackQueue));
-            } 
-
-            initCount++;
-        }
-
-        void ClosedAsync(uv_handle_t* async) {
-            EOS_DEBUG_METHOD();
-
-            delete async;
-            async = nullptr;
-        }
-
-        // TODO is it possible that calling uv_close(&async) while inside
-        // the async wake-up callback is what is causing the event loop to
-        // stick around too long?
-        void DestroyWaiter() {
-            EOS_DEBUG_METHOD_FMT(L"%i--", initCount);
-            assert(initCount >= 1);
-
-            initCount--;
-
-            if (initCount == 0) {
-                EOS_DEBUG_METHOD();
-
-                uv_close(reinterpret_cast<uv_handle_t*>(async), ClosedAsync);
-                uv_rwlock_destroy(&rwlock);
-            }
-        }
-        
-        void PrintCallbackChain(const wchar_t* msg) {
-            assert(msg);
-
-            if (!firstCallback) {
-                EOS_DEBUG(L"%ls, callback chain is empty\n", msg);
-                return;
-            }
-
-            {
-                int len = 1;
-                auto cb = firstCallback;
-                while (cb = cb->next)
-                    len++;
-
-                EOS_DEBUG(L"%ls, chain length: %i\n", msg, len);
-
-                cb = firstCallback;
-                do {
-                    cb->target;
-                    EOS_DEBUG(L" ** 0x%p->Notify()\n", cb->target);
-                } while (cb = cb->next);
-            }
-        }
-
-#ifdef NODE_12
-        void ProcessCallbackQueue(uv_async_t*) {
-#else
-        void ProcessCallbackQueue(uv_async_t*, int) {
-#endif
-            EOS_DEBUG_METHOD();
-
-            uv_rwlock_rdlock(&rwlock);
-
-            // Probably, uv_async_send() was called twice, and both calls resulted in a 
-            // wake up of the main event loop, even though the first wake-up cleared 
-            // both of the pending callbacks.
-            if (!firstCallback)
-                return;
-            
-#if defined(DEBUG)
-            assert(initCount);
-            assert(firstCallback);
-
-            PrintCallbackChain(L"Processing callbacks");
-#endif 
-
-            while (firstCallback) {
-                assert(firstCallback->target);
-                
-#if defined(DEBUG)
-                auto node = firstCallback; auto numCallbacks = 0;
-                while (node) {
-                    node = node->next;
-                    numCallbacks++;
-                }
-
-                assert(initCount >= numCallbacks);
-#endif
-
-                HANDLE hWait = firstCallback->target->GetWaitHandle();
-
-                auto rv = UnregisterWait(hWait);
-                // ERROR_IO_PENDING simply means the wait handle couldn't be unregistered because the callback is still executing
-                // http://msdn.microsoft.com/en-us/library/windows/desktop/ms686870(v=vs.85).aspx
-                if (rv || ::GetLastError() == ERROR_IO_PENDING)
-                    DestroyWaiter();
-                else
-                    EOS_DEBUG(L"UnregisterWait failed: %i\n", ::GetLastError());
-                
-                auto current = firstCallback;
-                firstCallback = firstCallback->next;
-
-                // If initCount is zero, the last callback must have been called,
-                // so firstCallback->next should be nullptr, and we don't need to
-                // lock the lock since it will have been destroyed
-                if (!initCount) {
-                    assert(!firstCallback && "*Must* have been the last callback in the queue if initCount is 0");
-                    DEBUG_ONLY(numberOfCallbacks++);
-                    current->target->Notify();
-                    current->target->Unref();
-                    delete current;
-                    return; 
-                }
-
-                uv_rwlock_rdunlock(&rwlock);
-                DEBUG_ONLY(numberOfCallbacks++);
-                current->target->Notify();
-                current->target->Unref();
-                uv_rwlock_rdlock(&rwlock);
-
-                delete current;
-            }
-            
-            // We've run out of callbacks, but there are still pending operations.
-            assert(initCount >= 0);
-            uv_rwlock_rdunlock(&rwlock);
-        }
-
+        // Runs on a Windows thread pool thread. The handle queues itself on its worker pool's
+        // completion queue, and is called back on the main thread from there.
         void NTAPI WaitCallback(PVOID data, BOOLEAN timeout) {
             EOS_DEBUG_METHOD();
 
-            // Another bogus assert - this wait callback
-            // runs on a separate thread, so querying the 
-            // state of the main thread makes no sense
-            // assert(!inCallback);
-
             if (timeout)
                 return;
 
-            uv_rwlock_wrlock(&rwlock);
-            
-            auto cb = new Callback(reinterpret_cast<INotify*>(data));
-
-#if defined(DEBUG)
-            EOS_DEBUG(L"Callback to be added: 0x%p->Notify()\n", cb->target);
-            PrintCallbackChain(L"About to add new callback");
-#endif 
-
-            // Enqueue the callbacks, in the order that they happened.
-            if (firstCallback) {
-                auto node = firstCallback;
-                while (node->next)
-                    node = node->next;
-                node->next = cb;
-            } else {
-                firstCallback = cb;
-            }
-            
-#if defined(DEBUG)
-            PrintCallbackChain(L"Added new callback");
-#endif 
-            
-            assert(async);
-            uv_async_send(async);
-            uv_rwlock_wrunlock(&rwlock);
+            DEBUG_ONLY(numberOfCallbacks++);
+            reinterpret_cast<INotify*>(data)->Signalled();
         }
     }
 
@@ -301,7 +134,6 @@ namespace Eos {
         EOS_DEBUG(L"\n");
         EOS_DEBUG(L"Number of Wait() calls: %i\n", Eos::Async::numberOfWaits);
         EOS_DEBUG(L"Number of callbacks: %i\n", Eos::Async::numberOfCallbacks);
-        EOS_DEBUG(L"initCount: %i\n", Eos::Async::initCount);
         EOS_DEBUG(L"\n");
         EOS_DEBUG(L"Number of constructed operations: %i\n", numberOfConstructedOperations);
         EOS_DEBUG(L"Number of destructed operations: %i\n", numberOfDestructedOperations);
@@ -315,8 +147,6 @@ namespace Eos {
     HANDLE Wait(INotify* notify) {
         EOS_DEBUG_METHOD();
 
-        Async::InitialiseWaiter();
-
         HANDLE hRegisteredWaitHandle = nullptr;
         if (RegisterWaitForSingleObject(&hRegisteredWaitHandle, notify->GetEventHandle(), &Async::WaitCallback, notify, INFINITE, WT_EXECUTEONLYONCE))
             notify->Ref();
@@ -508,29 +338,64 @@ namespace Eos {
 
 #pragma region Callbacks
     namespace {
-        // If anyone knows of a better way to do this, please tell me...
+        Persistent<Function> noop;
+        int callbackBatchDepth = 0;
+
+        NAN_METHOD(Noop) {
+            NanScope();
+            NanReturnUndefined();
+        }
+
         void InitCallbacks() {
             EOS_DEBUG_METHOD();
 
             NanScope();
 
-            auto code =
-                "function nextTick() {\
-                    var fn = this, args = arguments;\
-                    process.nextTick(function() {\
-                        fn.apply(this, args);\
-                    });\
-                 };\
-                 nextTick";
+            NanAssignPersistent(noop, NanNew<FunctionTemplate>(Noop)->GetFunction());
+        }
+    }
 
-            NanAssignPersistent(nextTick, Handle<Function>::Cast(Script::Compile(NanNew<String>(code))->Run()));
+    void MakeCompletionCallback(Handle<Object> receiver, Handle<Function> function, int argc, Handle<Value> argv[]) {
+        if (callbackBatchDepth == 0) {
+            NanMakeCallback(receiver, function, argc, argv);
+            return;
+        }
 
-            assert(!nextTick.IsEmpty());
+        TryCatch tc;
+        function->Call(receiver, argc, argv);
+        if (tc.HasCaught())
+            FatalException(tc);
+    }
+
+#if defined(NODE_12)
+    void SettlePromise(Handle<Object> receiver, Handle<Promise::Resolver> resolver, int argc, Handle<Value> argv[]) {
+        if (argc > 0 && !argv[0]->IsUndefined() && !argv[0]->IsNull()) {
+            resolver->Reject(argv[0]);
+        } else if (argc <= 2) {
+            resolver->Resolve(argc == 2 ? argv[1] : NanUndefined());
+        } else {
+            auto values = NanNew<Array>(argc - 1);
+            for (int i = 1; i < argc; i++)
+                values->Set(i - 1, argv[i]);
+            resolver->Resolve(values);
         }
+
+        // Runs the microtask queue, so that anything awaiting the promise continues now.
+        MakeCompletionCallback(receiver, NanNew(noop), 0, nullptr);
     }
+#endif
 
-    void NextTick(Handle<Function> function, int argc, Handle<Value> argv[]) {
-        NanNew(nextTick)->Call(function, argc, argv);
+    void BeginCallbackBatch() {
+        callbackBatchDepth++;
+    }
+
+    void EndCallbackBatch() {
+        assert(callbackBatchDepth > 0);
+
+        if (--callbackBatchDepth == 0) {
+            NanScope();
+            NanMakeCallback(NanGetCurrentContext()->Global(), NanNew(noop), 0, nullptr);
+        }
     }
 #pragma endregion
     
@@ -640,43 +505,8 @@ namespace Eos {
     }
 #endif // WIN32
 
-    Handle<Value> ConvertToJS(SQLPOINTER buffer, SQLLEN indicator, SQLLEN bufferLength, SQLSMALLINT cType) {
-        if (indicator == SQL_NO_TOTAL || indicator > bufferLength)
-            indicator = bufferLength;
-        
-        switch(cType) {
-        case SQL_C_SLONG:
-            return NanNew<Number>(*reinterpret_cast<SQLINTEGER*>(buffer));
-
-        case SQL_C_DOUBLE:
-            return NanNew<Number>(*reinterpret_cast<SQLDOUBLE*>(buffer));
-        
-        case SQL_C_BIT:
-            return *reinterpret_cast<SQLCHAR*>(buffer) ? NanTrue() : NanFalse();
-
-        case SQL_C_CHAR:
-            // Subtract one character iff buffer full, due to null terminator. The buffer length can be
-            // zero if the string was empty.
-            if (indicator > 0 && indicator == bufferLength)
-                --indicator;
-            return NanNew<String>(reinterpret_cast<const char*>(buffer), indicator);
-
-        case SQL_C_WCHAR:
-            // Subtract one character iff buffer full, due to null terminator. The indicator can be zero
-            // if the string was empty.
-            assert(indicator % sizeof(SQLWCHAR) == 0);
-            if (indicator > 0 && indicator == bufferLength)
-                indicator -= sizeof(SQLWCHAR);
-            return StringFromTChar(reinterpret_cast<const SQLWCHAR*>(buffer), indicator / 2);
-
-        case SQL_C_TYPE_TIMESTAMP: {
-            auto& ts = *reinterpret_cast<SQL_TIMESTAMP_STRUCT*>(buffer);
-            return NanNew<Date>(SQLTimeToV8Time(ts));
-        }
-
-        default:
-            return NanUndefined();
-        }
+    Handle<Value> ConvertToJS(SQLPOINTER buffer, SQLLEN indicator, SQLLEN bufferLength, SQLSMALLINT cType, int options) {
+        return GetDecoder(cType, options)(buffer, indicator, bufferLength);
     }
 
     void JSBuffer::Init(Handle<Object>) {
@@ -768,6 +598,69 @@ namespace Eos {
 
     Persistent<Function> JSBuffer::constructor_;
     ClassInitializer<JSBuffer> jsBufferInit;
+
+    void JSFloat64Array::Init(Handle<Object>) {
+        auto val = NanGetCurrentContext()->Global()->Get(NanSymbol("Float64Array"));
+        if (!val->IsFunction()) {
+            NanThrowError("The global Float64Array object is not a function.");
+            return;
+        }
+
+        NanAssignPersistent(constructor_, val.As<Function>());
+    }
+
+    Handle<Object> JSFloat64Array::New(size_t length, double*& data) {
+        assert(length <= INT_MAX);
+
+        data = nullptr;
+
+        Handle<Value> argv[] = { NanNew<Number>(length) };
+        auto array = Constructor()->NewInstance(1, argv);
+        if (array.IsEmpty())
+            return array;
+
+        if (!array->HasIndexedPropertiesInExternalArrayData()
+         || static_cast<size_t>(array->GetIndexedPropertiesExternalArrayDataLength()) != length
+         || (length && !array->GetIndexedPropertiesExternalArrayData())) 
+        {
+            NanThrowTypeError("The Float64Array constructor did not create an array with external storage");
+            return Handle<Object>();
+        }
+
+        data = static_cast<double*>(array->GetIndexedPropertiesExternalArrayData());
+        return array;
+    }
+
+    SQLSMALLINT UnwrapTypedArray(Handle<Value> value, SQLPOINTER& data, SQLLEN& length) {
+        if (!value->IsObject())
+            return 0;
+
+        auto array = value.As<Object>();
+        if (!array->HasIndexedPropertiesInExternalArrayData())
+            return 0;
+
+        SQLSMALLINT cType;
+        switch (array->GetIndexedPropertiesExternalArrayDataType()) {
+        case IF_NODE_12(kExternalInt32Array, kExternalIntArray): 
+            cType = SQL_C_SLONG;
+            break;
+        case IF_NODE_12(kExternalFloat64Array, kExternalDoubleArray): 
+            cType = SQL_C_DOUBLE;
+            break;
+        default:
+            return 0;
+        }
+
+        data = array->GetIndexedPropertiesExternalArrayData();
+        length = array->GetIndexedPropertiesExternalArrayDataLength();
+        if (length < 0 || (length && !data))
+            return -1;
+
+        return cType;
+    }
+
+    Persistent<Function> JSFloat64Array::constructor_;
+    ClassInitializer<JSFloat64Array> jsFloat64ArrayInit;
 }
 
 NODE_MODULE(eos, &Eos::Init)
@@ -30,6 +30,7 @@
 #endif 
 
 #include "strings.hpp"
+#include "completion.hpp"
 
 using namespace v8;
 using namespace node; 
@@ -105,17 +106,25 @@ namespace Eos {
         ClassInitializerRecord rec;
     };
 
-    struct INotify {
+    // A handle waiting for an asynchronous notification. When its event is signalled, 
+    // Signalled() queues it on a completion queue, and Completed() is called on the main 
+    // thread, which in turn calls Notify().
+    struct INotify : Completion {
         virtual void Notify() = 0;
 #if defined(EOS_ENABLE_ASYNC_NOTIFICATIONS)
         virtual HANDLE GetEventHandle() const = 0;
         virtual HANDLE GetWaitHandle() const = 0;
+        virtual void Signalled() = 0;
 #endif
 
         virtual void Ref() = 0;
         virtual void Unref() = 0;
     };
     
+    // The event loop of the isolate eos was loaded in, which environments deliver their
+    // completions to.
+    uv_loop_t* EventLoop();
+
 #if defined(DEBUG)
     extern int numberOfConstructedOperations;
     extern int numberOfDestructedOperations;
@@ -234,12 +243,58 @@ namespace Eos {
         static Persistent<Function> constructor_;
     };
 
-    void NextTick(Handle<Function> function, int argc, Handle<Value> argv[]);
+    // Float64Arrays are created through the global constructor, as there is no typed 
+    // array API common to all the versions of V8 we support.
+    struct JSFloat64Array {
+        static void Init(Handle<Object>);
+
+        // Creates a zero-filled array; data points to its backing store. If the array has no
+        // usable backing store, throws a TypeError and returns an empty handle.
+        static Handle<Object> New(size_t length, double*& data);
+        static Handle<Function> Constructor() { return NanNew(constructor_); }
+    private:
+        static Persistent<Function> constructor_;
+    };
+
+    // If value is an Int32Array or Float64Array, returns the C type of its elements and 
+    // sets data and length to its backing store and number of elements. Otherwise returns 0.
+    // Returns -1 if it is one of those arrays but its backing store is missing.
+    SQLSMALLINT UnwrapTypedArray(Handle<Value> value, SQLPOINTER& data, SQLLEN& length);
+
+    // Calls the callback of a completed operation from the event loop, with node::MakeCallback
+    // so that domains and the nextTick queue are handled. Between BeginCallbackBatch() and
+    // EndCallbackBatch(), callbacks are called directly, and the nextTick queue is only run
+    // once, by EndCallbackBatch().
+    void MakeCompletionCallback(Handle<Object> receiver, Handle<Function> function, int argc, Handle<Value> argv[]);
+    void BeginCallbackBatch();
+    void EndCallbackBatch();
+
+#if defined(NODE_12)
+    // Settles the promise of an operation begun without a callback, given the arguments
+    // the callback would have been called with: rejects it with argv[0] if that is an error,
+    // otherwise resolves it with argv[1], or an array of argv[1...] if there are several.
+    void SettlePromise(Handle<Object> receiver, Handle<Promise::Resolver> resolver, int argc, Handle<Value> argv[]);
+#endif
     void WeakCallback(Persistent<Value> ref, void *param);
 
+    // Flags which change how ConvertToJS represents a value in JavaScript.
+    enum ConvertOptions {
+        ConvertDefault = 0,
+
+        // SQL_C_TYPE_TIMESTAMP values become the number of milliseconds since 
+        // the epoch, instead of a Date object.
+        ConvertTimestampAsNumber = 1
+    };
+
     SQLSMALLINT GetSQLType(Handle<Value> jsValue);
     SQLSMALLINT GetCTypeForSQLType(SQLSMALLINT sqlType);
-    Handle<Value> ConvertToJS(SQLPOINTER buffer, SQLLEN indicator, SQLLEN bufferLength, SQLSMALLINT targetCType);
+
+    // Returns the number of milliseconds since the epoch, as used by Date objects.
+    double SQLTimeToV8Time(const SQL_TIMESTAMP_STRUCT& odbcTime);
+
+    // Converts a single value. Prefer GetDecoder (decoder.hpp) when converting many 
+    // values of the same type.
+    Handle<Value> ConvertToJS(SQLPOINTER buffer, SQLLEN indicator, SQLLEN bufferLength, SQLSMALLINT targetCType, int options = ConvertDefault);
     
     template <typename T>
     inline Persistent<T> Persist(Handle<T> value) {
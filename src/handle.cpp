@@ -1,5 +1,7 @@
 #include "handle.hpp"
 
+#include <utility>
+
 using namespace Eos;
 
 #if defined(DEBUG)
@@ -9,6 +11,16 @@ using namespace Eos;
 EosHandle::EosHandle(SQLSMALLINT handleType, const SQLHANDLE handle EOS_ASYNC_ONLY_ARG(HANDLE hEvent))
     : handleType_(handleType)
     , sqlHandle_(handle)
+    , operation_(nullptr)
+    , queuedOperations_(0)
+    , pendingTasks_(0)
+    , pool_(nullptr)
+    , affinity_(0)
+    , priority_(WorkerPool::LaneInteractive)
+    , timeout_(0)
+    , asyncPolling_(false)
+    , asyncEnabled_(false)
+    , freeing_(false)
 #if defined(EOS_ENABLE_ASYNC_NOTIFICATIONS)
     , hEvent_(hEvent)
     , hWait_(nullptr)
@@ -25,9 +37,16 @@ EosHandle::~EosHandle() {
     EOS_DEBUG_METHOD_FMT(L"handleType = %i, handle = 0x%p", handleType_, sqlHandle_);
     
     // Ref() and Unref() should ensure this does not happen
-    assert(operation_.IsEmpty() && "The handle should not be destructed while an operation is in progress");
+    assert(!operation_ && "The handle should not be destructed while an operation is in progress");
+    assert(queue_.empty() && queuedOperations_ == 0);
+
+    if (IsValid() && pool_ && handleType_ != SQL_HANDLE_ENV)
+        FreeHandleInBackground();
+    else
+        FreeHandle();
 
-    FreeHandle();
+    if (pool_)
+        pool_->Unref();
     
 #if defined(EOS_ENABLE_ASYNC_NOTIFICATIONS)
     assert(!hWait_ && "The handle should not be destructed until Notify() "
@@ -53,24 +72,158 @@ void EosHandle::Init ( const char* className
 
     auto sig0 = NanNew<Signature>(ft);
     EOS_SET_METHOD(ft, "free", EosHandle, Free, sig0);
+    EOS_SET_ACCESSOR(ft, "priority", EosHandle, GetPriority, SetPriority);
+}
+
+NAN_GETTER(EosHandle::GetPriority) const {
+    EosMethodReturnValue(NanNew<String>(Priority() == WorkerPool::LaneBatch ? "batch" : "interactive"));
+}
+
+NAN_SETTER(EosHandle::SetPriority) {
+    WorkerPool::Lane priority;
+    if (value->Equals(NanNew<String>("interactive"))) {
+        priority = WorkerPool::LaneInteractive;
+    } else if (value->Equals(NanNew<String>("batch"))) {
+        priority = WorkerPool::LaneBatch;
+    } else {
+        NanThrowError("The priority must be 'interactive' or 'batch'");
+        return;
+    }
+
+    if (priority != Priority() && CheckPriorityChange())
+        priority_ = priority;
+}
+
+void EosHandle::Enqueue(IOperation* op) {
+    EOS_DEBUG_METHOD_FMT(L"handleType = %i, queued = %u", handleType_, queuedOperations_);
+
+    if (queuedOperations_++ > 0) {
+        op->Hold();
+        queue_.push_back(op);
+        return;
+    }
+
+    Start(op);
+}
+
+void EosHandle::Start(IOperation* op) {
+#if defined(EOS_ENABLE_ASYNC_NOTIFICATIONS)
+    if (hEvent_ && op->IsAsyncCapable())
+        return RunAsync(op);
+#endif
+
+    op->RunOnThreadPool();
+}
+
+bool EosHandle::OperationFinished() {
+    EOS_DEBUG_METHOD_FMT(L"handleType = %i, queued = %u", handleType_, queuedOperations_);
+
+    assert(queuedOperations_ > 0);
+    if (--queuedOperations_ == 0) {
+        assert(queue_.empty());
+        return false;
+    }
+
+    // Operations begun by the callback are queued behind the waiting ones, since the count
+    // is still above 0.
+    return true;
+}
+
+void EosHandle::StartNextOperation() {
+    EOS_DEBUG_METHOD_FMT(L"handleType = %i, queued = %u", handleType_, queuedOperations_);
+
+    assert(queuedOperations_ > 0 && !queue_.empty());
+
+    auto op = queue_.front();
+    queue_.pop_front();
+
+    // Starting the operation holds it again, so it is only released afterwards.
+    Start(op);
+    op->Release();
+}
+
+#if defined(EOS_ENABLE_ASYNC_NOTIFICATIONS)
+void EosHandle::RunAsync(IOperation* operation) {
+    bool completedSynchronously = operation->BeginAsync();
+
+    // Only register a wait if it did not complete synchronously
+    // It should be safe to register the wait even if the event is already signalled.
+    if (completedSynchronously) {
+        EOS_DEBUG(L"%hs Completed synchronously\n", operation->GetName());
+        pool_->Post(operation);
+        return;
+    }
+
+    EOS_DEBUG(L"%hs Executing asynchronously\n", operation->GetName());
+    if (hWait_ = Eos::Wait(this)) {
+        operation_ = operation;
+        pool_->AddPending();
+    } else {
+        NanThrowError(OdbcError("Unable to begin asynchronous operation"));
+    }
+}
+#endif
+
+void EosHandle::SetPool(WorkerPool* pool, unsigned int affinity) {
+    assert(pool && !pool_);
+
+    pool->Ref();
+    pool_ = pool;
+    affinity_ = affinity;
+}
+
+SQLRETURN EosHandle::SetAsyncEnabled(bool enabled) {
+    EOS_DEBUG_METHOD_FMT(L"enabled = %i", enabled);
+
+    assert(handleType_ == SQL_HANDLE_STMT);
+
+    auto ret = SQLSetStmtAttrW(
+        sqlHandle_,
+        SQL_ATTR_ASYNC_ENABLE,
+        (SQLPOINTER)(enabled ? SQL_ASYNC_ENABLE_ON : SQL_ASYNC_ENABLE_OFF),
+        SQL_IS_UINTEGER);
+
+    if (SQL_SUCCEEDED(ret))
+        asyncEnabled_ = enabled;
+
+    return ret;
 }
 
 #if defined(EOS_ENABLE_ASYNC_NOTIFICATIONS)
+// Called on the thread which waited for the event.
+void EosHandle::Signalled() {
+    pool_->Finished(this);
+}
+
+void EosHandle::Completed() {
+    EOS_DEBUG_METHOD_FMT(L"handleType = %i", handleType_);
+
+    // ERROR_IO_PENDING simply means the wait handle couldn't be unregistered because the callback is still executing
+    // http://msdn.microsoft.com/en-us/library/windows/desktop/ms686870(v=vs.85).aspx
+    if (!UnregisterWait(hWait_) && ::GetLastError() != ERROR_IO_PENDING)
+        EOS_DEBUG(L"UnregisterWait failed: %i\n", ::GetLastError());
+
+    Notify();
+
+    // Balances the Ref() in Wait().
+    Unref();
+}
+
 void EosHandle::Notify() {
     EOS_DEBUG_METHOD_FMT(L"handleType = %i", handleType_);
     
-    if (operation_.IsEmpty())
+    if (!operation_)
         EOS_DEBUG(L"Notify() called after FreeHandle()!\n");
 
     assert(hEvent_ && hWait_ && "handle has been freed while an operation was in progress");
-    assert(!operation_.IsEmpty());
+    assert(operation_);
 
     NanScope();
-    Handle<Object> op = NanNew(operation_);
-    NanDisposePersistent(operation_);
+    auto op = operation_;
+    operation_ = nullptr;
     hWait_ = nullptr;
 
-    ObjectWrap::Unwrap<IOperation>(op)->OnCompletedAsync();
+    op->OnCompletedAsync();
 }
 
 void EosHandle::DisableAsynchronousNotifications() {
@@ -93,17 +246,23 @@ void EosHandle::DisableAsynchronousNotifications() {
 void EosHandle::NotifyThreadPool() {
     EOS_DEBUG_METHOD_FMT(L"handleType = %i", handleType_);
     
-    assert(!operation_.IsEmpty());
+    assert(operation_);
 
-    NanScope();
-
-    NanDisposePersistent(operation_);
+    operation_ = nullptr;
 }
 
 NAN_METHOD(EosHandle::Free) {
     EOS_DEBUG_METHOD_FMT(L"handleType = %i", handleType_);
 
-    auto inProgress = !operation_.IsEmpty();
+    // free(callback) waits for the queued operations, but not for tasks, which use the
+    // handle outside the queue.
+    if (pendingTasks_ > 0)
+        return NanThrowError("Cannot free the handle - an operation is in progress");
+
+    if (args.Length() > 0 && args[0]->IsFunction())
+        return BeginFree(args);
+
+    auto inProgress = operation_ || queuedOperations_ > 0;
 #if defined(EOS_ENABLE_ASYNC_NOTIFICATIONS)
     if (hWait_)
         inProgress = true;
@@ -112,6 +271,9 @@ NAN_METHOD(EosHandle::Free) {
     if (inProgress)
         return NanThrowError("Cannot free the handle - an operation is in progress");
 
+    if (Recycle())
+        NanReturnUndefined();
+
     auto ret = FreeHandle();
     if (!SQL_SUCCEEDED(ret))
         return NanThrowError(GetLastError());
@@ -119,13 +281,17 @@ NAN_METHOD(EosHandle::Free) {
     NanReturnUndefined();
 }
 
+NAN_METHOD(EosHandle::BeginFree) {
+    return NanThrowError("This handle can only be freed synchronously");
+}
+
 SQLRETURN EosHandle::FreeHandle() {
     EOS_DEBUG_METHOD_FMT(L"handleType = %i", handleType_);
 
     if (!IsValid())
         return SQL_SUCCESS_WITH_INFO;
 
-    bool executing = !operation_.IsEmpty();
+    bool executing = operation_ != nullptr;
 #if defined(EOS_ENABLE_ASYNC_NOTIFICATIONS)
     if (hWait_)
         executing = true;
@@ -135,12 +301,9 @@ SQLRETURN EosHandle::FreeHandle() {
 #if defined(DEBUG)
         EOS_DEBUG(L"Called FreeHandle() while an asynchronous operation is executing\n");
 
-        auto op = !operation_.IsEmpty() 
-            ? ObjectWrap::Unwrap<IOperation>(NanNew(operation_))
-            : nullptr;
-
         EOS_DEBUG(L"Operation was started at:");
-        Eos::PrintStackTrace(NanNew(op->GetStackTrace()));
+        if (operation_)
+            Eos::PrintStackTrace(operation_->GetStackTrace());
 #endif
     }
 
@@ -148,6 +311,32 @@ SQLRETURN EosHandle::FreeHandle() {
     if (!SQL_SUCCEEDED(ret))
         return ret;
 
+    HandleFreed();
+    return SQL_SUCCESS;
+}
+
+void EosHandle::SwapHandle(EosHandle* other) {
+    EOS_DEBUG_METHOD_FMT(L"handleType = %i, handle = 0x%p, other = 0x%p", handleType_, sqlHandle_, other->sqlHandle_);
+
+    assert(handleType_ == other->handleType_);
+    assert(pool_ == other->pool_ && affinity_ == other->affinity_);
+    assert(!IsBusy() && !other->IsBusy() && !operation_ && !other->operation_);
+    assert(!pendingTasks_ && !other->pendingTasks_);
+
+    std::swap(sqlHandle_, other->sqlHandle_);
+    std::swap(asyncPolling_, other->asyncPolling_);
+    std::swap(asyncEnabled_, other->asyncEnabled_);
+
+#if defined(EOS_ENABLE_ASYNC_NOTIFICATIONS)
+    // The event is set on the SQL handle (SQL_ATTR_ASYNC_STMT_EVENT), so it goes with it.
+    assert(!hWait_ && !other->hWait_);
+    std::swap(hEvent_, other->hEvent_);
+#endif
+}
+
+void EosHandle::HandleFreed() {
+    EOS_DEBUG_METHOD_FMT(L"handleType = %i", handleType_);
+
     sqlHandle_ = SQL_NULL_HANDLE;
 
 #if defined(EOS_ENABLE_ASYNC_NOTIFICATIONS)
@@ -159,9 +348,63 @@ SQLRETURN EosHandle::FreeHandle() {
     }
 #endif
 
-    NanDisposePersistent(operation_);
+    operation_ = nullptr;
+}
 
-    return SQL_SUCCESS;
+namespace {
+    // Frees a garbage collected handle on the thread its operations ran on, so that it is 
+    // freed after any statements freed before it. Nothing is left to report a failure to.
+    struct FreeHandleTask : WorkerPool::Task {
+        FreeHandleTask(WorkerPool* pool, SQLSMALLINT handleType, SQLHANDLE handle, EosHandle* parent)
+            : pool_(pool)
+            , parent_(parent)
+            , handleType_(handleType)
+            , handle_(handle)
+            , ret_(SQL_SUCCESS)
+        {
+            pool_->Ref();
+            if (parent_)
+                parent_->Ref();
+        }
+
+        void Run() {
+            ret_ = SQLFreeHandle(handleType_, handle_);
+        }
+
+        void Completed() {
+            if (!SQL_SUCCEEDED(ret_))
+                EOS_DEBUG(L"Unable to free handle 0x%p (handleType = %i) in the background\n", handle_, handleType_);
+
+            // The parent (e.g. a connection's environment) can only be freed after this.
+            if (parent_)
+                parent_->Unref();
+
+            pool_->Unref();
+            delete this;
+        }
+
+    private:
+        WorkerPool* pool_;
+        EosHandle* parent_;
+        SQLSMALLINT handleType_;
+        SQLHANDLE handle_;
+        SQLRETURN ret_;
+    };
+}
+
+void EosHandle::FreeHandleInBackground(EosHandle* parent) {
+    EOS_DEBUG_METHOD_FMT(L"handleType = %i", handleType_);
+
+    assert(IsValid() && pool_);
+
+    auto task = new(nothrow) FreeHandleTask(pool_, handleType_, sqlHandle_, parent);
+    if (!task) {
+        FreeHandle();
+        return;
+    }
+
+    pool_->Submit(affinity_, WorkerPool::LaneInteractive, task);
+    HandleFreed();
 }
 
 #if defined(DEBUG)
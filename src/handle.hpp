@@ -4,6 +4,7 @@
 #include "operation.hpp"
 
 #include <uv.h>
+#include <deque>
 
 #if defined(EOS_ENABLE_ASYNC_NOTIFICATIONS)
 #define EOS_ASYNC_ONLY_ARG(x) , x
@@ -18,14 +19,54 @@ namespace Eos {
         ~EosHandle();
         
         NAN_METHOD(Free);
+        NAN_GETTER(GetPriority) const;
+        NAN_SETTER(SetPriority);
     protected:
         // In case the derived handle class needs to do some extra freeing.
         virtual void VirtualFree() {}
+
+        // free(callback): begins a FreeOperation, for handles which have them.
+        virtual NAN_METHOD(BeginFree);
+
+        // Called by free() without a callback once no operations are in progress. Returns 
+        // true if the handle was put to other use, and given up, instead of being freed.
+        virtual bool Recycle() { return false; }
     public:
         SQLHANDLE GetHandle() const { return sqlHandle_; }
         SQLSMALLINT GetHandleType() const { return handleType_; }
         Handle<Value> GetLastError() { return Eos::GetLastError(handleType_, sqlHandle_); }
-        IOperation* Operation() { return ObjectWrap::Unwrap<IOperation>(NanNew(operation_)); }
+        IOperation* Operation() { return operation_; }
+
+        // The worker pool which runs this handle's operations, and the thread within it.
+        WorkerPool* Pool() const { return pool_; }
+        unsigned int Affinity() const { return affinity_; }
+        void SetPool(WorkerPool* pool, unsigned int affinity);
+
+        // The lane this handle's operations are queued in on the worker threads. New 
+        // connections take their environment's priority. Statements always use their 
+        // connection's, so that the operations on a connection and its statements, which 
+        // share a thread, cannot overtake each other.
+        virtual WorkerPool::Lane Priority() const { return priority_; }
+        void SetPriority(WorkerPool::Lane priority) { priority_ = priority; }
+
+        // Called before the priority is set from JS. Throws and returns false if it cannot
+        // be changed.
+        virtual bool CheckPriorityChange() { return true; }
+
+        // The time in milliseconds an operation on this handle may run for before the 
+        // watchdog cancels it, or 0 for no limit.
+        unsigned int OperationTimeout() const { return timeout_; }
+        void SetOperationTimeout(unsigned int timeout) { timeout_ = timeout; }
+
+        // True if this handle's operations are run by the pool's polling thread, with 
+        // SQL_ATTR_ASYNC_ENABLE on. Only statements can be polled.
+        bool AsyncPolling() const { return asyncPolling_; }
+        void SetAsyncPolling() { asyncPolling_ = asyncEnabled_ = true; }
+
+        // Worker and polling threads only: whether SQL_ATTR_ASYNC_ENABLE is currently on. 
+        // Polled operations turn it on, and other operations turn it back off.
+        bool AsyncEnabled() const { return asyncEnabled_; }
+        SQLRETURN SetAsyncEnabled(bool enabled);
         
 #if defined(DEBUG)
         static std::vector<EosHandle*> active_;
@@ -58,77 +99,105 @@ namespace Eos {
         HANDLE /*INotify::*/GetEventHandle() const { return hEvent_; } // Including interface name gives strange IntelliSense errors
         HANDLE /*INotify::*/GetWaitHandle() const { return hWait_; } 
         void INotify::Notify();        
+        void /*INotify::*/Signalled();
+        void /*Completion::*/Completed();
 
         virtual void DisableAsynchronousNotifications();
 #endif
 
         void NotifyThreadPool();
 
+        // Called when an operation on this handle has completed, before its callback, so 
+        // that the callback sees the handle as idle unless more operations are queued. 
+        // Returns true if one is, and StartNextOperation() must be called after the callback,
+        // since the next operation could overwrite buffers (e.g. bound columns) which the 
+        // callback reads.
+        bool OperationFinished();
+        void StartNextOperation();
+
+        // True if an operation is running or queued on this handle.
+        bool IsBusy() const { return queuedOperations_ > 0; }
+
+        // Called once SQLFreeHandle has succeeded, possibly on another thread, to forget the
+        // handle.
+        void HandleFreed();
+
+        // Set by FreeOperation when it is begun, so that no more operations are queued 
+        // behind it, and cleared if it fails.
+        void SetFreeing(bool freeing) { freeing_ = freeing; }
+
+        // Counts worker pool tasks which use this handle outside of an operation, such as the
+        // connects started by Environment.openMany() and Statement.cancel(callback), so that 
+        // free() refuses to free the handle underneath them.
+        void TaskStarted() { pendingTasks_++; }
+        void TaskFinished() { assert(pendingTasks_ > 0); pendingTasks_--; }
+        bool HasPendingTasks() const { return pendingTasks_ > 0; }
+
     protected:
         static void Init(
             const char* className, 
             Persistent<FunctionTemplate>& ft, 
             NanFunctionCallback New);
 
+        // Starts an operation, or if one is already running on this handle, queues it to be
+        // started when the others have completed.
         template<typename TOp, size_t argc>
         _NAN_METHOD_RETURN_TYPE Begin(Handle<Value> (&argv)[argc]) {
-            if (!IsValid())
-                return NanThrowError("This handle has been freed.");
-            
-#if defined(EOS_ENABLE_ASYNC_NOTIFICATIONS)
-            if (hWait_)
-                return NanThrowError("This handle is already busy.");
-#endif
-
-            IOperation* currentOp = nullptr;
-            if (!operation_.IsEmpty()) {
-                currentOp = ObjectWrap::Unwrap<IOperation>(NanNew(operation_));
-                return NanThrowError("An operation is already in progress on this handle.");
-            }
+            if (auto msg = CheckCanBegin())
+                return NanThrowError(msg);
 
             auto op = TOp::Construct(argv).template As<Object>();
             if (op.IsEmpty())
                 NanReturnUndefined(); // Probably the constructor threw
 
-#if defined(EOS_ENABLE_ASYNC_NOTIFICATIONS)
-            if (hEvent_) {
-                RunAsync<TOp>(op);
-                NanReturnUndefined();
-            }
-#endif
-            
-            ObjectWrap::Unwrap<TOp>(op)->RunOnThreadPool();
+            auto operation = ObjectWrap::Unwrap<IOperation>(op);
+            auto promise = operation->GetPromise();
+            Enqueue(operation);
 
-            NanReturnUndefined();
+            EosMethodReturnValue(promise);
         }
 
-#if defined(EOS_ENABLE_ASYNC_NOTIFICATIONS)
-        template <typename TOp>
-        void RunAsync(Handle<Object> op) {
-            bool completedSynchronously = 
-                ObjectWrap::Unwrap<TOp>(op)->BeginAsync();
-
-            // Only register a wait if it did not complete synchronously
-            // It should be safe to register the wait even if the event is already signalled.
-            if (completedSynchronously) {
-                EOS_DEBUG(L"%hs Completed synchronously\n", TOp::Name());
-                return;
-            }
+        // Begins an operation from TOp::Acquire(), which has no JS object. The handle must 
+        // have been checked with CheckCanBegin() before acquiring it.
+        _NAN_METHOD_RETURN_TYPE BeginPooled(IOperation* op) {
+            if (!op)
+                return NanThrowError("Out of memory allocating the operation");
 
-            EOS_DEBUG(L"%hs Executing asynchronously\n", TOp::Name());
-            if (hWait_ = Eos::Wait(this))
-                NanAssignPersistent(operation_, op);
-            else { 
-                NanThrowError(OdbcError("Unable to begin asynchronous operation"));
-                return;
-            }
+            auto promise = op->GetPromise();
+            Enqueue(op);
 
+            EosMethodReturnValue(promise);
         }
+
+        void Enqueue(IOperation* op);
+        void Start(IOperation* op);
+
+#if defined(EOS_ENABLE_ASYNC_NOTIFICATIONS)
+        void RunAsync(IOperation* op);
 #endif
 
         bool IsValid() const { return sqlHandle_ != SQL_NULL_HANDLE; }
         SQLRETURN FreeHandle();
 
+        // Returns the reason operations cannot be begun on the handle, if it has been freed 
+        // or free(callback) has been called, or nullptr.
+        const char* CheckCanBegin() const {
+            if (!IsValid())
+                return "This handle has been freed.";
+            if (freeing_)
+                return "This handle is being freed.";
+            return nullptr;
+        }
+
+        // Exchanges the SQL handles of two idle handles of the same type and thread, along 
+        // with the state which belongs to the SQL handle rather than to this object.
+        void SwapHandle(EosHandle* other);
+
+        // Frees the handle on its worker thread without waiting, for handles which are 
+        // garbage collected, since freeing a connection or statement can block on the network.
+        // If parent is given, it is kept alive until the handle has been freed.
+        void FreeHandleInBackground(EosHandle* parent = nullptr);
+
     private:
         EosHandle(const EosHandle& other); // = delete;
         
@@ -136,8 +205,66 @@ namespace Eos {
         HANDLE hEvent_, hWait_;
 #endif
 
-        Persistent<Object> operation_;
+        // The operation waiting for an asynchronous notification, if any.
+        IOperation* operation_;
+
+        // Operations waiting for the running one to complete, and the number of operations 
+        // which have been begun but not completed, including the running one.
+        std::deque<IOperation*> queue_;
+        unsigned int queuedOperations_;
+
+        // Tasks started with TaskStarted() which have not finished.
+        unsigned int pendingTasks_;
+
+        WorkerPool* pool_;
+        unsigned int affinity_;
+        WorkerPool::Lane priority_;
+        unsigned int timeout_;
+        bool asyncPolling_, asyncEnabled_, freeing_;
         SQLHANDLE sqlHandle_;
         SQLSMALLINT handleType_; 
     };
+
+    // Frees a connection or statement handle on its worker thread, once the operations queued
+    // on it have completed. Each owner type defines its constructor_ and ClassInitializer.
+    template <class TOwner>
+    struct FreeOperation : Operation<TOwner, FreeOperation<TOwner> > {
+        static const char* Name() { return "FreeOperation"; }
+
+        enum { Pollable = false, AsyncCapable = false };
+
+        static EOS_OPERATION_CONSTRUCTOR(New, TOwner) {
+            EOS_DEBUG_METHOD();
+
+            if (args.Length() < 2)
+                return NanError("Too few arguments");
+
+            (new FreeOperation())->Wrap(args.Holder());
+            owner->SetFreeing(true);
+
+            EOS_OPERATION_CONSTRUCTOR_RETURN();
+        }
+
+        SQLRETURN CallOverride() {
+            return SQLFreeHandle(
+                TOwner::HandleType,
+                this->Owner()->GetHandle());
+        }
+
+        // Not watched for the handle's timeout, since the watchdog's SQLCancelHandle could 
+        // run on the handle after it has been freed.
+        uint64_t Timeout() { return 0; }
+
+        void CallbackOverride(SQLRETURN ret) {
+            EOS_DEBUG_METHOD();
+
+            this->Owner()->SetFreeing(false);
+
+            if (!SQL_SUCCEEDED(ret))
+                return this->CallbackErrorOverride(ret);
+
+            this->Owner()->HandleFreed();
+            this->MakeCallback(0, nullptr);
+        }
+    };
 }
@@ -0,0 +1,144 @@
+#include "kernels.hpp"
+
+#include <cstring>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define EOS_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace Eos {
+    namespace Kernels {
+        namespace {
+#if defined(EOS_SSE2)
+            // Converts four 32-bit integers to four doubles.
+            inline void StoreInt32x4(__m128i v, double* out) {
+                _mm_storeu_pd(out, _mm_cvtepi32_pd(v));
+                _mm_storeu_pd(out + 2, _mm_cvtepi32_pd(_mm_srli_si128(v, 8)));
+            }
+#endif
+
+            // Days since 1970-01-01 in the proleptic Gregorian calendar.
+            // See http://howardhinnant.github.io/date_algorithms.html#days_from_civil
+            inline double DaysFromCivil(int y, int m, int d) {
+                y -= m <= 2;
+                const int era = (y >= 0 ? y : y - 399) / 400;
+                const int yoe = y - era * 400;
+                const int doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+                const int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+                return double(era) * 146097 + doe - 719468;
+            }
+
+            // Milliseconds since the epoch of the whole hour containing the timestamp, 
+            // treating it as UTC.
+            inline double UtcHourMs(const SQL_TIMESTAMP_STRUCT& ts) {
+                return (DaysFromCivil(ts.year, ts.month, ts.day) * 24 + ts.hour) * 3600000.0;
+            }
+        }
+
+        void WidenInt16(const SQLSMALLINT* values, double* out, std::size_t count) {
+            std::size_t i = 0;
+#if defined(EOS_SSE2)
+            for (; i + 8 <= count; i += 8) {
+                auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+                // Sign extend each half to 32 bits
+                StoreInt32x4(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16), out + i);
+                StoreInt32x4(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16), out + i + 4);
+            }
+#endif
+            for (; i < count; i++)
+                out[i] = values[i];
+        }
+
+        void WidenInt32(const SQLINTEGER* values, double* out, std::size_t count) {
+            std::size_t i = 0;
+#if defined(EOS_SSE2)
+            for (; i + 4 <= count; i += 4)
+                StoreInt32x4(_mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i)), out + i);
+#endif
+            for (; i < count; i++)
+                out[i] = values[i];
+        }
+
+        void NormalizeBits(const SQLCHAR* values, double* out, std::size_t count) {
+            std::size_t i = 0;
+#if defined(EOS_SSE2)
+            const auto zero = _mm_setzero_si128(), one = _mm_set1_epi8(1);
+            for (; i + 16 <= count; i += 16) {
+                auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+                auto bits = _mm_andnot_si128(_mm_cmpeq_epi8(v, zero), one);
+                auto lo = _mm_unpacklo_epi8(bits, zero), hi = _mm_unpackhi_epi8(bits, zero);
+                StoreInt32x4(_mm_unpacklo_epi16(lo, zero), out + i);
+                StoreInt32x4(_mm_unpackhi_epi16(lo, zero), out + i + 4);
+                StoreInt32x4(_mm_unpacklo_epi16(hi, zero), out + i + 8);
+                StoreInt32x4(_mm_unpackhi_epi16(hi, zero), out + i + 12);
+            }
+#endif
+            for (; i < count; i++)
+                out[i] = values[i] ? 1 : 0;
+        }
+
+        bool PackNullBitmap(const SQLLEN* indicators, unsigned char* bitmap, std::size_t count) {
+            unsigned char any = 0;
+            std::size_t i = 0;
+
+            // Written without branches so that the compiler can vectorise it.
+            for (; i + 8 <= count; i += 8) {
+                unsigned char byte = 0;
+                for (int j = 0; j < 8; j++)
+                    byte |= static_cast<unsigned char>(indicators[i + j] == SQL_NULL_DATA) << j;
+                bitmap[i / 8] = byte;
+                any |= byte;
+            }
+
+            if (i < count) {
+                unsigned char byte = 0;
+                for (int j = 0; i + j < count; j++)
+                    byte |= static_cast<unsigned char>(indicators[i + j] == SQL_NULL_DATA) << j;
+                bitmap[i / 8] = byte;
+                any |= byte;
+            }
+
+            return any != 0;
+        }
+
+        void ApplyNullBitmap(const unsigned char* bitmap, double* out, std::size_t count) {
+            const auto nan = std::numeric_limits<double>::quiet_NaN();
+            for (std::size_t i = 0; i < count; i += 8) {
+                auto byte = bitmap[i / 8];
+                for (int j = 0; byte; j++, byte >>= 1)
+                    if (byte & 1)
+                        out[i + j] = nan;
+            }
+        }
+
+        void TimestampsToEpochMs(const SQL_TIMESTAMP_STRUCT* values, double* out, std::size_t count) {
+            // SQLTimeToV8Time interprets timestamps as local time (unless TIMEGM is defined),
+            // which means a call to mktime() or similar per value. Instead, do the calendar 
+            // arithmetic here, and only ask the C library for the UTC offset when the hour 
+            // changes. Consecutive rows very often fall within the same hour.
+            SQLSMALLINT year = -1;
+            SQLUSMALLINT month = 0, day = 0, hour = 0;
+            double offset = 0;
+
+            for (std::size_t i = 0; i < count; i++) {
+                const auto& ts = values[i];
+                auto hourMs = UtcHourMs(ts);
+
+#if !defined(TIMEGM)
+                if (ts.year != year || ts.month != month || ts.day != day || ts.hour != hour) {
+                    SQL_TIMESTAMP_STRUCT start = ts;
+                    start.minute = start.second = 0;
+                    start.fraction = 0;
+
+                    offset = SQLTimeToV8Time(start) - hourMs;
+                    year = ts.year; month = ts.month; day = ts.day; hour = ts.hour;
+                }
+#endif
+
+                out[i] = hourMs + offset + (ts.minute * 60 + ts.second) * 1000.0 + ts.fraction / 1000000.0;
+            }
+        }
+    }
+}
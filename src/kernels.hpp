@@ -0,0 +1,31 @@
+#pragma once
+
+#include "eos.hpp"
+
+#include <cstddef>
+
+// Conversion kernels for column-wise blocks of values. These work on whole arrays 
+// at once, so that they can use SIMD instructions (SSE2 where available) and do
+// not touch V8 at all. 
+namespace Eos {
+    namespace Kernels {
+        // Widen integers to doubles, e.g. for filling a Float64Array.
+        void WidenInt16(const SQLSMALLINT* values, double* out, std::size_t count);
+        void WidenInt32(const SQLINTEGER* values, double* out, std::size_t count);
+
+        // Convert SQL_C_BIT values (which may be any non-zero byte) to exactly 0 or 1.
+        void NormalizeBits(const SQLCHAR* values, double* out, std::size_t count);
+
+        // Pack an indicator array into a bitmap with one bit per value (least significant 
+        // bit first), set if the indicator is SQL_NULL_DATA. The bitmap must have room for
+        // (count + 7) / 8 bytes. Returns true if any value was null.
+        bool PackNullBitmap(const SQLLEN* indicators, unsigned char* bitmap, std::size_t count);
+
+        // Set out[i] to NaN for each null value in the bitmap.
+        void ApplyNullBitmap(const unsigned char* bitmap, double* out, std::size_t count);
+
+        // Convert timestamps to the number of milliseconds since the epoch, exactly as 
+        // SQLTimeToV8Time does, but without calling into the C library for each value.
+        void TimestampsToEpochMs(const SQL_TIMESTAMP_STRUCT* values, double* out, std::size_t count);
+    }
+}
@@ -1,29 +1,25 @@
 #pragma once 
 
 #include "eos.hpp"
+#include "pool.hpp"
 
 #include <uv.h>
 
+#include <vector>
+
 #if defined(DEBUG)
 #define DEBUG_ONLY(x) x
-#include <vector>
 #include <algorithm>
 #else
 #define DEBUG_ONLY(x)
 #endif
 
 namespace Eos {
-    struct IOperation : ObjectWrap {
-        IOperation() {
+    struct IOperation : ObjectWrap, WorkerPool::Task {
+        IOperation() : pooled_(false) {
             EOS_DEBUG_METHOD();
         
-#if defined(DEBUG)
-            NanAssignPersistent(stackTrace_, 
-                IF_NODE_12
-                    ( StackTrace::CurrentStackTrace(v8::Isolate::GetCurrent(), 10)
-                    , StackTrace::CurrentStackTrace(10))
-                );
-#endif
+            DEBUG_ONLY(CaptureStackTrace());
         }
 
         virtual ~IOperation() {
@@ -35,6 +31,10 @@ namespace Eos {
                 EOS_DEBUG(L"Operation callback not disposed. This should be done sooner.\n");
                 NanDisposePersistent(callback_);
             }
+#if defined(NODE_12)
+            if (!resolver_.IsEmpty())
+                NanDisposePersistent(resolver_);
+#endif
         }
         
 #if defined(EOS_ENABLE_ASYNC_NOTIFICATIONS)
@@ -42,6 +42,14 @@ namespace Eos {
 #endif
 
 #if defined(DEBUG)
+        void CaptureStackTrace() {
+            NanAssignPersistent(stackTrace_, 
+                IF_NODE_12
+                    ( StackTrace::CurrentStackTrace(v8::Isolate::GetCurrent(), 10)
+                    , StackTrace::CurrentStackTrace(10))
+                );
+        }
+
         Handle<StackTrace> GetStackTrace() const {
             // The stack trace is only disposed of when the IOperation is destructed, at which point
             // there would be nothing to call GetStackTrace().
@@ -85,7 +93,7 @@ namespace Eos {
                 it != activeOperations_.end();
                 ++it)
             {
-                ops->Set(ops->Length(), NanObjectWrapHandle((*it)));
+                ops->Set(ops->Length(), (*it)->GetWrapper());
             }
 
             NanReturnValue(ops);
@@ -94,6 +102,51 @@ namespace Eos {
 
         virtual const char* GetName() const = 0;
 
+        virtual void RunOnThreadPool() = 0;
+#if defined(EOS_ENABLE_ASYNC_NOTIFICATIONS)
+        virtual bool BeginAsync() = 0;
+        virtual bool IsAsyncCapable() const = 0;
+#endif
+
+        // Returns the operation's JS object, creating one if it is a pooled operation.
+        virtual Handle<Object> GetWrapper() = 0;
+
+        // Where promises are supported, the callback may be omitted (undefined), in which
+        // case the operation settles a promise instead.
+        static bool IsCallback(Handle<Value> value) {
+#if defined(NODE_12)
+            if (value->IsUndefined())
+                return true;
+#endif
+            return value->IsFunction();
+        }
+
+        void SetCallback(Handle<Value> callback) {
+            assert(IsCallback(callback));
+
+            if (callback->IsFunction())
+                NanAssignPersistent(callback_, callback.As<Function>());
+#if defined(NODE_12)
+            else
+                NanAssignPersistent(resolver_, Promise::Resolver::New(v8::Isolate::GetCurrent()));
+#endif
+        }
+
+        // The promise to return from the method which began the operation, or undefined if 
+        // a callback was given.
+        Handle<Value> GetPromise() {
+#if defined(NODE_12)
+            if (!resolver_.IsEmpty())
+                return NanNew(resolver_)->GetPromise();
+#endif
+            return NanUndefined();
+        }
+
+        // Keep the operation alive while it is queued or running. Pooled operations are
+        // kept alive by their owner instead, until they are returned to the pool.
+        void Hold() { if (!pooled_) Ref(); }
+        void Release() { if (!pooled_) Unref(); }
+
     protected:
 
         virtual SQLRETURN CallOverride() = 0;
@@ -105,8 +158,22 @@ namespace Eos {
             return NanNew(callback_);
         }
 
+        bool HasCallback() const {
+#if defined(NODE_12)
+            return !callback_.IsEmpty() || !resolver_.IsEmpty();
+#else
+            return !callback_.IsEmpty();
+#endif
+        }
+
     protected:
         Persistent<Function> callback_;
+#if defined(NODE_12)
+        Persistent<Promise::Resolver> resolver_;
+#endif
+
+        // True if the operation came from Operation::Acquire and has no JS object.
+        bool pooled_;
 
         DEBUG_ONLY(Persistent<StackTrace> stackTrace_);
     };
@@ -203,15 +270,49 @@ namespace Eos {
 
             DEBUG_ONLY(numberOfDestructedOperations++);
 
-            if (!owner_.IsEmpty()) {
-                EOS_DEBUG(L"Operation owner not disposed! You should do this earlier!\n");
-                NanDisposePersistent(owner_);
-            }
-
             ownerPtr_ = nullptr;
             assert(begun_ && completed_);
         }
 
+        // Takes an operation from the pool of completed ones (or allocates one), for hot
+        // operations which are begun many times. Pooled operations have no JS object of their
+        // own, and return to the pool once they complete. Returns nullptr if out of memory.
+        static TOp* Acquire(TOwner* owner, Handle<Value> callback) {
+            TOp* op;
+            if (free_.empty()) {
+                op = new(nothrow) TOp();
+                if (!op)
+                    return nullptr;
+            } else {
+                op = free_.back();
+                free_.pop_back();
+                DEBUG_ONLY(op->CaptureStackTrace());
+            }
+
+            op->pooled_ = true;
+            op->begun_ = op->completed_ = op->sync_ = false;
+            op->SetOwner(owner);
+            op->SetCallback(callback);
+            return op;
+        }
+
+        // Pooled operations are only given a JS object if something asks for one, after 
+        // which they belong to it and are not returned to the pool.
+        Handle<Object> GetWrapper() {
+            if (NanObjectWrapHandle(this).IsEmpty()) {
+                assert(pooled_);
+
+                Wrap(Constructor()->InstanceTemplate()->NewInstance());
+                pooled_ = false;
+
+                // Balances the Release() when the operation completes.
+                if (begun_ && !completed_)
+                    Hold();
+            }
+
+            return NanObjectWrapHandle(this);
+        }
+
         template<size_t argc>
         static Local<Object> Construct(Handle<Value> (&argv)[argc]) {
             return Constructor()->GetFunction()->NewInstance(argc, argv); 
@@ -243,7 +344,7 @@ namespace Eos {
             if (!TOwner::Constructor()->HasInstance(args[0]))
                 return NanThrowTypeError("Bad argument");
 
-            if (!args[args.Length() - 1]->IsFunction())
+            if (!IsCallback(args[args.Length() - 1]))
                 return NanThrowTypeError("Last argument should be a callback function");
 
             auto owner = ObjectWrap::Unwrap<TOwner>(args[0]->ToObject());
@@ -253,9 +354,8 @@ namespace Eos {
                 return NanThrowError(error);
 
             auto op = ObjectWrap::Unwrap<TOp>(args.Holder());
-            op->ownerPtr_ = owner;
-            NanAssignPersistent(op->owner_, NanObjectWrapHandle(owner));
-            NanAssignPersistent(op->callback_, args[args.Length() - 1].As<Function>());
+            op->SetOwner(owner);
+            op->SetCallback(args[args.Length() - 1]);
 
             NanReturnValue(args.Holder());
         };
@@ -265,12 +365,15 @@ namespace Eos {
         }
 
         TOwner* Owner() { 
-            assert(!owner_.IsEmpty());
             assert(ownerPtr_);
             return ownerPtr_; 
         }
 
 #if defined(EOS_ENABLE_ASYNC_NOTIFICATIONS)
+        bool IsAsyncCapable() const {
+            return TOp::AsyncCapable;
+        }
+
         // Returns true if the operation completed synchronously.
         bool BeginAsync() {
             EOS_DEBUG_METHOD();
@@ -317,8 +420,8 @@ namespace Eos {
             sync_ = true;
             DEBUG_ONLY(numberOfSyncOperations++);
 
-            Complete();
-
+            // The caller posts the operation to be completed on the next loop iteration,
+            // so that the callback is never called before the JS method returns.
             return true; // Synchronous
         }
 
@@ -344,16 +447,23 @@ namespace Eos {
 
             Begin();
 
-            new(&req_) uv_work_t;
-            req_.data = this;
-
-            uv_queue_work(
-                uv_default_loop(),
-                &req_,
-                &UVWorkCallback,
-                &UVCompletedCallback);
+            auto owner = Owner();
+            if (TOp::Pollable && owner->AsyncPolling())
+                owner->Pool()->SubmitPolled(this);
+            else
+                owner->Pool()->Submit(owner->Affinity(), owner->Priority(), this);
         }
 
+        // Operations can be run by the polling thread if CallOverride() makes a single ODBC 
+        // call, which can simply be repeated until it stops returning SQL_STILL_EXECUTING. 
+        // Operations which make several calls hide this with enum { Pollable = false }.
+        enum { Pollable = true };
+
+        // Operations whose ODBC calls have no asynchronous mode at all, such as SQLFreeHandle,
+        // hide this with enum { AsyncCapable = false }, so that they run on the worker thread
+        // even for handles which use asynchronous notifications.
+        enum { AsyncCapable = true };
+
     protected:
         const char* GetName() const {
             return TOp::Name();
@@ -368,8 +478,15 @@ namespace Eos {
             DEBUG_ONLY(numberOfBegunOperations++);
             DEBUG_ONLY(activeOperations_.push_back(this));
 
-            Owner()->Ref();
-            this->Ref();
+            Hold();
+        }
+
+        // The owner is kept alive from when the operation is created until its callback is 
+        // made, including while it is queued.
+        void SetOwner(TOwner* owner) {
+            assert(!ownerPtr_);
+            ownerPtr_ = owner;
+            owner->Ref();
         }
 
         // Default implementation.
@@ -387,14 +504,34 @@ namespace Eos {
             MakeCallback(argv);
         }
 
+        // Must be called exactly once by CallbackOverride, which is always called from the 
+        // event loop. The next queued operation on the owner is only started once the 
+        // callback has returned, so that it cannot overwrite bound buffers the callback reads.
+        // Promise reactions run later, so they get no such guarantee.
         void MakeCallback(int argc, Handle<Value>* argv) {
+            auto owner = Owner();
+            auto startNext = owner->OperationFinished();
+
+#if defined(NODE_12)
+            if (!resolver_.IsEmpty()) {
+                auto resolver = NanNew(resolver_);
+                NanDisposePersistent(resolver_);
+
+                SettlePromise(NanObjectWrapHandle(owner), resolver, argc, argv);
+                if (startNext)
+                    owner->StartNextOperation();
+                owner->Unref();
+                return;
+            }
+#endif
+
             auto cb = GetCallback();
-            Owner()->Unref();
-            Unref();
-            //NanMakeCallback(NanGetCurrentContext()->Global(), cb, argc, argv);
-            NanDisposePersistent(owner_);
             NanDisposePersistent(callback_);
-            NextTick(cb, argc, argv);
+
+            MakeCompletionCallback(NanObjectWrapHandle(owner), cb, argc, argv);
+            if (startNext)
+                owner->StartNextOperation();
+            owner->Unref();
         }
 
         // Convenience overload
@@ -426,37 +563,84 @@ namespace Eos {
             CallbackOverride(result_);
             if (tc.HasCaught())
                 FatalException(tc);
+
+            assert(!HasCallback() && "CallbackOverride() did not call MakeCallback()");
+
+            if (pooled_)
+                ReturnToPool();
+            else
+                Release();
         }
 
-#pragma region UV thread pool code
-        static void UVWorkCallback(uv_work_t* req) {
-            auto op = static_cast<Operation<TOwner, TOp>*>(req->data);
-            assert(op && &op->req_ == req);
+        void ReturnToPool() {
+            assert(pooled_ && completed_);
 
-            op->result_ = op->CallOverride();
+            ownerPtr_ = nullptr;
+            if (!callback_.IsEmpty())
+                NanDisposePersistent(callback_);
+#if defined(NODE_12)
+            if (!resolver_.IsEmpty())
+                NanDisposePersistent(resolver_);
+#endif
+
+            if (free_.size() < MaxPooled)
+                free_.push_back(static_cast<TOp*>(this));
+            else
+                delete this;
         }
 
-        static void UVCompletedCallback(uv_work_t* req, int status) {
-            auto op = static_cast<Operation<TOwner, TOp>*>(req->data);
-            assert(op && &op->req_ == req);
-            assert(op->begun_ && !op->completed_);
+#pragma region Worker pool code
+        void Run() {
+            // A polled operation may have left asynchronous execution on.
+            auto owner = Owner();
+            if (owner->AsyncEnabled() && !SQL_SUCCEEDED(result_ = owner->SetAsyncEnabled(false)))
+                return;
+
+            result_ = CallOverride();
+        }
+
+        uint64_t Timeout() {
+            return static_cast<uint64_t>(Owner()->OperationTimeout()) * 1000 * 1000;
+        }
+
+        // The call which is running fails with SQLSTATE HY008 (operation canceled).
+        void Cancel() {
+            EOS_DEBUG(L"%hs timed out, cancelling\n", TOp::Name());
+            SQLCancelHandle(TOwner::HandleType, Owner()->GetHandle());
+        }
+
+        bool Poll() {
+            auto owner = Owner();
+            if (!owner->AsyncEnabled() && !SQL_SUCCEEDED(result_ = owner->SetAsyncEnabled(true)))
+                return true;
+
+            result_ = CallOverride();
+            return result_ != SQL_STILL_EXECUTING;
+        }
+
+        void Completed() {
+            assert(begun_ && !completed_);
 
             NanScope();
 
-            op->Complete();
+            Complete();
         }
 #pragma endregion 
 
     private:
         Operation(const Operation<TOwner, TOp>& other); // = delete
 
-        // For thread pool tasks
-        uv_work_t req_;
         SQLRETURN result_;
 
         bool completed_, begun_, sync_;
         TOwner* ownerPtr_;
-        Persistent<Object> owner_;
         static Persistent<FunctionTemplate> constructor_;
+
+        // Completed pooled operations, ready to be reused by Acquire().
+        enum { MaxPooled = 64 };
+        static std::vector<TOp*> free_;
     };
+
+    template <class TOwner, class TOp>
+    std::vector<TOp*> Operation<TOwner, TOp>::free_;
 }
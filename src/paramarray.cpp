@@ -0,0 +1,241 @@
+#include "paramarray.hpp"
+#include "buffer.hpp"
+
+#include <cstring>
+
+using namespace Eos;
+
+namespace {
+    Handle<Value> GetValue(Handle<Array> rows, uint32_t row, int index) {
+        auto value = rows->Get(row);
+        if (index < 0)
+            return value;
+        return value.As<Object>()->Get(index);
+    }
+
+    // The number of bytes needed to hold the longest value in the column, without 
+    // a null terminator.
+    SQLLEN GetLongestValue(SQLSMALLINT cType, Handle<Array> rows, int index) {
+        SQLLEN longest = 0;
+
+        for (uint32_t i = 0; i < rows->Length(); i++) {
+            auto value = GetValue(rows, i, index);
+            if (value->IsNull() || value->IsUndefined())
+                continue;
+
+            SQLLEN length = 0;
+            if (cType == SQL_C_CHAR) {
+                length = value->ToString()->Utf8Length();
+            } else if (cType == SQL_C_WCHAR) {
+                length = value->ToString()->Length() * sizeof(SQLWCHAR);
+            } else if (cType == SQL_C_BINARY && value->IsObject()) {
+                SQLPOINTER data;
+                if (JSBuffer::Unwrap(value.As<Object>(), data, length))
+                    length = 0;
+            }
+
+            longest = max(longest, length);
+        }
+
+        return longest;
+    }
+}
+
+ParameterArray::ParameterArray(SQLULEN rowCount)
+    : statuses_(new(nothrow) SQLUSMALLINT[rowCount])
+    , rowCount_(rowCount)
+    , paramsProcessed_(0)
+{
+    EOS_DEBUG_METHOD_FMT(L"rowCount = %lu", (unsigned long)rowCount);
+}
+
+ParameterArray::~ParameterArray() {
+    EOS_DEBUG_METHOD();
+
+    for (auto it = columns_.begin(); it != columns_.end(); ++it) {
+        if (it->ownsValues)
+            delete[] it->values;
+        delete[] it->indicators;
+    }
+
+    delete[] statuses_;
+}
+
+const char* ParameterArray::AddColumn(
+    SQLSMALLINT sqlType, SQLULEN columnSize, SQLSMALLINT decimalDigits,
+    Handle<Array> rows, int index) 
+{
+    assert(rows->Length() == rowCount_);
+
+    if (!statuses_)
+        return "Out of memory allocating the parameter array";
+
+    Column column;
+    column.sqlType = sqlType;
+    column.cType = GetCTypeForSQLType(sqlType);
+    column.decimalDigits = decimalDigits;
+    column.columnSize = columnSize;
+    column.elementLength = Buffers::GetDesiredBufferLength(column.cType);
+    column.ownsValues = true;
+
+    if (!column.elementLength) {
+        // Variable length types are sized to fit the longest value, plus room for the
+        // null terminator which FillInputBuffer may write.
+        auto longest = GetLongestValue(column.cType, rows, index);
+        column.elementLength = longest + sizeof(SQLWCHAR);
+
+        if (!columnSize) {
+            auto chars = column.cType == SQL_C_WCHAR ? longest / sizeof(SQLWCHAR) : longest;
+            column.columnSize = max<SQLULEN>(chars, 1);
+        }
+    }
+
+    if (rowCount_ > SQLULEN(INT_MAX) / column.elementLength)
+        return "The parameter array is too large";
+
+    column.values = new(nothrow) char[column.elementLength * rowCount_];
+    column.indicators = new(nothrow) SQLLEN[rowCount_];
+
+    if (!column.values || !column.indicators) {
+        delete[] column.values;
+        delete[] column.indicators;
+        return "Out of memory allocating the parameter array";
+    }
+
+    for (uint32_t i = 0; i < rowCount_; i++) {
+        auto value = GetValue(rows, i, index);
+        auto buffer = column.values + i * column.elementLength;
+
+        if (value->IsNull() || value->IsUndefined()) {
+            column.indicators[i] = SQL_NULL_DATA;
+            continue;
+        }
+
+        if (column.cType == SQL_C_BINARY) {
+            SQLPOINTER data;
+            SQLLEN length;
+            if (!value->IsObject() || JSBuffer::Unwrap(value.As<Object>(), data, length)) {
+                delete[] column.values;
+                delete[] column.indicators;
+                return "Binary parameter values must be Buffers";
+            }
+
+            memcpy(buffer, data, length);
+            column.indicators[i] = length;
+            continue;
+        }
+
+        if (column.cType == SQL_C_TYPE_TIMESTAMP && !value->IsDate()) {
+            delete[] column.values;
+            delete[] column.indicators;
+            return "Timestamp parameter values must be Dates";
+        }
+
+        column.indicators[i] = Buffers::FillInputBuffer(column.cType, value, buffer, column.elementLength);
+    }
+
+    columns_.push_back(column);
+    return nullptr;
+}
+
+const char* ParameterArray::AddExternalColumn(
+    SQLSMALLINT sqlType, SQLSMALLINT cType, SQLSMALLINT decimalDigits,
+    SQLPOINTER values, const unsigned char* nullBitmap) 
+{
+    if (!statuses_)
+        return "Out of memory allocating the parameter array";
+
+    Column column;
+    column.sqlType = sqlType;
+    column.cType = cType;
+    column.decimalDigits = decimalDigits;
+    column.columnSize = 0;
+    column.elementLength = Buffers::GetDesiredBufferLength(cType);
+    column.values = reinterpret_cast<char*>(values);
+    column.indicators = nullptr;
+    column.ownsValues = false;
+
+    assert(column.elementLength > 0 && "External columns must have a fixed-length type");
+
+    // For fixed-length types, a null indicator pointer means none of the values are null.
+    if (nullBitmap) {
+        column.indicators = new(nothrow) SQLLEN[rowCount_];
+        if (!column.indicators)
+            return "Out of memory allocating the parameter array";
+
+        for (SQLULEN i = 0; i < rowCount_; i++)
+            column.indicators[i] = (nullBitmap[i / 8] >> (i % 8)) & 1 ? SQL_NULL_DATA : column.elementLength;
+    }
+
+    columns_.push_back(column);
+    return nullptr;
+}
+
+SQLRETURN ParameterArray::Bind(SQLHSTMT hStmt) {
+    EOS_DEBUG_METHOD();
+
+    auto ret = SQLSetStmtAttrW(hStmt, SQL_ATTR_PARAM_BIND_TYPE, (SQLPOINTER)SQL_PARAM_BIND_BY_COLUMN, SQL_IS_UINTEGER);
+    if (!SQL_SUCCEEDED(ret))
+        return ret;
+
+    ret = SQLSetStmtAttrW(hStmt, SQL_ATTR_PARAMSET_SIZE, (SQLPOINTER)rowCount_, SQL_IS_UINTEGER);
+    if (!SQL_SUCCEEDED(ret))
+        return ret;
+
+    ret = SQLSetStmtAttrW(hStmt, SQL_ATTR_PARAM_STATUS_PTR, statuses_, SQL_IS_POINTER);
+    if (!SQL_SUCCEEDED(ret))
+        return ret;
+
+    ret = SQLSetStmtAttrW(hStmt, SQL_ATTR_PARAMS_PROCESSED_PTR, &paramsProcessed_, SQL_IS_POINTER);
+    if (!SQL_SUCCEEDED(ret))
+        return ret;
+
+    for (std::size_t i = 0; i < columns_.size(); i++) {
+        auto& column = columns_[i];
+
+        ret = SQLBindParameter(
+            hStmt,
+            static_cast<SQLUSMALLINT>(i + 1),
+            SQL_PARAM_INPUT,
+            column.cType,
+            column.sqlType,
+            column.columnSize,
+            column.decimalDigits,
+            column.values,
+            column.elementLength,
+            column.indicators);
+
+        if (!SQL_SUCCEEDED(ret))
+            return ret;
+    }
+
+    return SQL_SUCCESS;
+}
+
+SQLRETURN ParameterArray::Unbind(SQLHSTMT hStmt) {
+    EOS_DEBUG_METHOD();
+
+    auto ret = SQLFreeStmt(hStmt, SQL_RESET_PARAMS);
+    if (!SQL_SUCCEEDED(ret))
+        return ret;
+
+    ret = SQLSetStmtAttrW(hStmt, SQL_ATTR_PARAM_STATUS_PTR, nullptr, SQL_IS_POINTER);
+    if (!SQL_SUCCEEDED(ret))
+        return ret;
+
+    ret = SQLSetStmtAttrW(hStmt, SQL_ATTR_PARAMS_PROCESSED_PTR, nullptr, SQL_IS_POINTER);
+    if (!SQL_SUCCEEDED(ret))
+        return ret;
+
+    return SQLSetStmtAttrW(hStmt, SQL_ATTR_PARAMSET_SIZE, (SQLPOINTER)1, SQL_IS_UINTEGER);
+}
+
+Handle<Array> ParameterArray::GetStatuses() const {
+    auto statuses = NanNew<Array>(static_cast<int>(rowCount_));
+
+    // Rows after the last one processed have undefined status values.
+    for (SQLULEN i = 0; i < rowCount_; i++)
+        statuses->Set(i, NanNew<Integer>(i < paramsProcessed_ ? statuses_[i] : SQL_PARAM_UNUSED));
+
+    return statuses;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "eos.hpp"
+
+#include <vector>
+
+namespace Eos {
+    // Column-wise arrays of parameter values, bound so that a single SQLExecute
+    // executes the statement once for each row (see SQL_ATTR_PARAMSET_SIZE).
+    struct ParameterArray {
+        ParameterArray(SQLULEN rowCount);
+        ~ParameterArray();
+
+        // Adds the next parameter, copying the value for each row from rows[row][index],
+        // or from rows[row] if index is negative. columnSize may be 0, in which case it is 
+        // calculated from the longest value for character and binary types. Returns an 
+        // error message on failure.
+        const char* AddColumn(
+            SQLSMALLINT sqlType, SQLULEN columnSize, SQLSMALLINT decimalDigits,
+            Handle<Array> rows, int index);
+
+        // Adds the next parameter, binding values (an array of rowCount fixed-length values
+        // of type cType) directly. The caller must keep values alive until the array is 
+        // unbound. If nullBitmap is given, a set bit (LSB first) means that row is null.
+        const char* AddExternalColumn(
+            SQLSMALLINT sqlType, SQLSMALLINT cType, SQLSMALLINT decimalDigits,
+            SQLPOINTER values, const unsigned char* nullBitmap);
+
+        // Binds the parameters and sets the statement attributes for executing the array.
+        SQLRETURN Bind(SQLHSTMT hStmt);
+
+        // Unbinds all parameters and restores the statement to executing one set of 
+        // parameters at a time.
+        static SQLRETURN Unbind(SQLHSTMT hStmt);
+
+        // The SQL_PARAM_* status of each row after execution.
+        Handle<Array> GetStatuses() const;
+
+        SQLULEN RowCount() const { return rowCount_; }
+        SQLULEN ParamsProcessed() const { return paramsProcessed_; }
+
+    private:
+        ParameterArray(const ParameterArray&); // = delete
+        void operator=(const ParameterArray&); // = delete
+
+        struct Column {
+            SQLSMALLINT sqlType, cType;
+            SQLULEN columnSize;
+            SQLSMALLINT decimalDigits;
+            SQLLEN elementLength;
+            char* values;
+            SQLLEN* indicators;
+            bool ownsValues;
+        };
+
+        std::vector<Column> columns_;
+        SQLUSMALLINT* statuses_;
+        SQLULEN rowCount_, paramsProcessed_;
+    };
+}
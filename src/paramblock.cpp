@@ -0,0 +1,213 @@
+#include "paramblock.hpp"
+#include "handle.hpp"
+#include "buffer.hpp"
+
+#include <cstring>
+
+using namespace Eos;
+
+Persistent<FunctionTemplate> ParameterBlock::constructor_;
+
+void ParameterBlock::Init(Handle<Object> exports) {
+    NanAssignPersistent(constructor_, NanNew<FunctionTemplate>());
+    Constructor()->SetClassName(NanSymbol("ParameterBlock"));
+    Constructor()->InstanceTemplate()->SetInternalFieldCount(1);
+
+    auto sig0 = NanNew<Signature>(Constructor());
+
+    EOS_SET_METHOD(Constructor(), "setValues", ParameterBlock, SetValues, sig0);
+    EOS_SET_GETTER(Constructor(), "length", ParameterBlock, GetLength);
+}
+
+ParameterBlock::ParameterBlock()
+    : statement_(nullptr)
+    , arena_(nullptr)
+    , indicators_(nullptr)
+{
+    EOS_DEBUG_METHOD();
+}
+
+ParameterBlock::~ParameterBlock() {
+    EOS_DEBUG_METHOD();
+
+    delete[] arena_;
+}
+
+const char* ParameterBlock::Bind(
+    EosHandle* statement,
+    Handle<Array> descriptions,
+    SQLRETURN& ret,
+    Handle<Object>& result) 
+{
+    EOS_DEBUG_METHOD();
+
+    auto count = descriptions->Length();
+    if (count == 0 || count > USHRT_MAX)
+        return "The number of parameters must be between 1 and 65535";
+
+    auto block = new(nothrow) ParameterBlock();
+    if (!block)
+        return "Out of memory allocating the parameter block";
+
+    // The indicators come first in the arena, followed by each value aligned to 8 bytes.
+    SQLLEN arenaLength = count * sizeof(SQLLEN);
+
+    for (uint32_t i = 0; i < count; i++) {
+        // Each parameter is either an SQL type, or { type, [columnSize], [decimalDigits], [length] }.
+        auto desc = descriptions->Get(i);
+        Handle<Value> type = desc, length = NanUndefined();
+
+        Slot slot;
+        slot.columnSize = 0;
+        slot.decimalDigits = 0;
+
+        if (desc->IsObject()) {
+            auto obj = desc.As<Object>();
+            type = obj->Get(NanSymbol("type"));
+            length = obj->Get(NanSymbol("length"));
+            slot.columnSize = obj->Get(NanSymbol("columnSize"))->Uint32Value();
+            slot.decimalDigits = static_cast<SQLSMALLINT>(obj->Get(NanSymbol("decimalDigits"))->Int32Value());
+        }
+
+        if (!type->IsInt32()) {
+            delete block;
+            return "Each parameter must be an SQL type, or an object with a type";
+        }
+
+        slot.sqlType = static_cast<SQLSMALLINT>(type->Int32Value());
+        slot.cType = GetCTypeForSQLType(slot.sqlType);
+        slot.length = Buffers::GetDesiredBufferLength(slot.cType);
+
+        if (!slot.length) {
+            auto charSize = slot.cType == SQL_C_WCHAR ? sizeof(SQLWCHAR) : 1;
+
+            if (length->IsInt32() && length->Int32Value() > 0)
+                slot.length = length->Int32Value();
+            else if (slot.columnSize)
+                slot.length = slot.columnSize * charSize;
+            else
+                slot.length = DefaultElementLength;
+
+            if (!slot.columnSize)
+                slot.columnSize = max<SQLULEN>(slot.length / charSize, 1);
+        }
+
+        slot.offset = (arenaLength + 7) & ~SQLLEN(7);
+        arenaLength = slot.offset + slot.length;
+
+        if (arenaLength > INT_MAX) {
+            delete block;
+            return "The parameter block is too large";
+        }
+
+        block->slots_.push_back(slot);
+    }
+
+    block->arena_ = new(nothrow) char[arenaLength];
+    if (!block->arena_) {
+        delete block;
+        return "Out of memory allocating the parameter block";
+    }
+
+    block->indicators_ = reinterpret_cast<SQLLEN*>(block->arena_);
+    block->statement_ = statement;
+
+    result = Constructor()->GetFunction()->NewInstance();
+    block->Wrap(result);
+
+    for (std::size_t i = 0; i < block->slots_.size(); i++) {
+        auto& slot = block->slots_[i];
+        block->indicators_[i] = SQL_NULL_DATA;
+
+        ret = SQLBindParameter(
+            statement->GetHandle(),
+            static_cast<SQLUSMALLINT>(i + 1),
+            SQL_PARAM_INPUT,
+            slot.cType,
+            slot.sqlType,
+            slot.columnSize,
+            slot.decimalDigits,
+            block->arena_ + slot.offset,
+            slot.length,
+            &block->indicators_[i]);
+
+        if (!SQL_SUCCEEDED(ret))
+            break;
+    }
+
+    return nullptr;
+}
+
+NAN_METHOD(ParameterBlock::SetValues) {
+    EOS_DEBUG_METHOD();
+
+    if (args.Length() < 1 || !args[0]->IsArray())
+        return NanThrowTypeError("ParameterBlock::SetValues() requires an array of values");
+
+    if (!statement_)
+        return NanThrowError("The parameter block is no longer bound to its statement");
+
+    // The driver reads the arena and indicators while the statement executes.
+    if (statement_->IsBusy())
+        return NanThrowError("The parameter block's values cannot be changed while its statement is busy");
+
+    auto values = args[0].As<Array>();
+    if (values->Length() != slots_.size())
+        return NanThrowRangeError("There must be exactly one value for each parameter");
+
+    for (std::size_t i = 0; i < slots_.size(); i++) {
+        if (auto msg = SetValue(i, values->Get(i)))
+            return NanThrowError(msg);
+    }
+
+    NanReturnUndefined();
+}
+
+const char* ParameterBlock::SetValue(std::size_t index, Handle<Value> value) {
+    auto& slot = slots_[index];
+    auto buffer = arena_ + slot.offset;
+
+    if (value->IsNull() || value->IsUndefined()) {
+        indicators_[index] = SQL_NULL_DATA;
+        return nullptr;
+    }
+
+    switch (slot.cType) {
+    case SQL_C_BINARY: {
+        SQLPOINTER data;
+        SQLLEN length;
+        if (!value->IsObject() || JSBuffer::Unwrap(value.As<Object>(), data, length))
+            return "Binary parameter values must be Buffers";
+        if (length > slot.length)
+            return "A parameter value is too long for the parameter block";
+
+        memcpy(buffer, data, length);
+        indicators_[index] = length;
+        return nullptr;
+    }
+
+    case SQL_C_CHAR:
+        if (value->ToString()->Utf8Length() > slot.length)
+            return "A parameter value is too long for the parameter block";
+        break;
+
+    case SQL_C_WCHAR:
+        if (value->ToString()->Length() * SQLLEN(sizeof(SQLWCHAR)) > slot.length)
+            return "A parameter value is too long for the parameter block";
+        break;
+
+    case SQL_C_TYPE_TIMESTAMP:
+        if (!value->IsDate())
+            return "Timestamp parameter values must be Dates";
+        break;
+    }
+
+    indicators_[index] = Buffers::FillInputBuffer(slot.cType, value, buffer, slot.length);
+    return nullptr;
+}
+
+NAN_GETTER(ParameterBlock::GetLength) const {
+    EosMethodReturnValue(NanNew<Integer>(static_cast<uint32_t>(slots_.size())));
+}
+
+namespace { ClassInitializer<ParameterBlock> init; } 
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "eos.hpp"
+
+#include <vector>
+
+namespace Eos {
+    struct EosHandle;
+
+    // A set of input parameters bound into one contiguous buffer, whose values are all
+    // set by a single call to setValues(). Created by Statement.bindParameters().
+    struct ParameterBlock: ObjectWrap {
+        ~ParameterBlock();
+
+        static void Init(Handle<Object> exports);
+
+        // Allocates the buffer for the parameters described by descriptions, and binds
+        // them to parameters 1 to descriptions.length. Returns an error message on failure, 
+        // or nullptr if the parameters were bound (whether or not SQLBindParameter failed).
+        static const char* Bind(
+            EosHandle* statement,
+            Handle<Array> descriptions,
+            SQLRETURN& ret,
+            Handle<Object>& result);
+
+        NAN_METHOD(SetValues);
+        NAN_GETTER(GetLength) const;
+
+        // Called by the statement when any of the block's parameters are unbound or bound to
+        // something else, or the statement is freed, after which setValues() throws. The 
+        // statement keeps the block alive while any of its parameters may still be bound.
+        void Detach() { statement_ = nullptr; }
+
+        static Handle<FunctionTemplate> Constructor() { return NanNew(constructor_); }
+
+        // The buffer size for each value of a variable-length type, if none is given.
+        enum { DefaultElementLength = 512 };
+
+    private:
+        ParameterBlock();
+
+        struct Slot {
+            SQLSMALLINT sqlType, cType;
+            SQLULEN columnSize;
+            SQLSMALLINT decimalDigits;
+            SQLLEN offset, length;
+        };
+
+        const char* SetValue(std::size_t index, Handle<Value> value);
+
+        std::vector<Slot> slots_;
+        EosHandle* statement_;
+        char* arena_;
+        SQLLEN* indicators_;
+
+        static Persistent<FunctionTemplate> constructor_;
+    };
+}
@@ -1,6 +1,9 @@
 #include "parameter.hpp"
+#include "handle.hpp"
 #include "buffer.hpp"
 
+#include <cstring>
+
 using namespace Eos;
 using namespace Eos::Buffers;
 
@@ -19,6 +22,7 @@ void Parameter::Init(Handle<Object> exports) {
     EOS_SET_GETTER(Constructor(), "bufferLength", Parameter, GetBufferLength);
     EOS_SET_GETTER(Constructor(), "index", Parameter, GetIndex);
     EOS_SET_GETTER(Constructor(), "kind", Parameter, GetKind);
+    EOS_SET_ACCESSOR(Constructor(), "timestampAsNumber", Parameter, GetTimestampAsNumber, SetTimestampAsNumber);
 }
 
 Parameter::Parameter
@@ -39,6 +43,13 @@ Parameter::Parameter
     , buffer_(buffer)
     , length_(length)
     , indicator_(indicator)
+    , convertOptions_(ConvertDefault)
+    , decoder_(GetDecoder(cType))
+    , ownedBuffer_(nullptr)
+    , dataAtExec_(indicator == SQL_DATA_AT_EXEC)
+    , statement_(nullptr)
+    , columnSize_(0)
+    , decimalDigits_(0)
 {
     EOS_DEBUG_METHOD_FMT(L"buffer = 0x%p, length = %i", buffer, length);
 
@@ -49,6 +60,9 @@ Parameter::Parameter
 }
 
 NAN_GETTER(Parameter::GetBuffer) const {
+    if (ownedBuffer_)
+        NanReturnNull();
+
     EosMethodReturnValue(NanNew(bufferObject_));
 }
 
@@ -104,6 +118,9 @@ NAN_SETTER(Parameter::SetBytesInBuffer) {
         return;
     }
 
+    if (!CheckNotExecuting())
+        return;
+
     auto bytes = value->IntegerValue();
     if (bytes < 0 || bytes > length_) {
         NanThrowError("bytesInBuffer must be non-negative and less than or equal to the buffer length");
@@ -121,6 +138,17 @@ NAN_GETTER(Parameter::GetKind) const {
     EosMethodReturnValue(NanNew<Integer>(inOutType_));
 }
 
+NAN_GETTER(Parameter::GetTimestampAsNumber) const {
+    EosMethodReturnValue(NanNew<Boolean>((convertOptions_ & ConvertTimestampAsNumber) != 0));
+}
+
+NAN_SETTER(Parameter::SetTimestampAsNumber) {
+    if (value->BooleanValue())
+        SetConversionOptions(convertOptions_ | ConvertTimestampAsNumber);
+    else
+        SetConversionOptions(convertOptions_ & ~ConvertTimestampAsNumber);
+}
+
 SQLLEN Parameter::BytesInBuffer() const {
     auto bytes = indicator_;
 
@@ -240,20 +268,49 @@ NAN_GETTER(Parameter::GetValue) const {
     if (cType_ == SQL_C_BINARY) {
         assert(indicator_ >= 0 || indicator_ == SQL_NO_TOTAL);
 
+        if (ownedBuffer_) {
+            SQLPOINTER data;
+            SQLLEN length = BytesInBuffer();
+            auto copy = JSBuffer::New(length);
+            JSBuffer::Unwrap(copy, data, length);
+            memcpy(data, buffer_, length);
+            EosMethodReturnValue(copy);
+        }
+
         if (indicator_ >= length_ || indicator_ == SQL_NO_TOTAL)
             EosMethodReturnValue(NanNew(bufferObject_));
         EosMethodReturnValue(JSBuffer::Slice(NanNew(bufferObject_), 0, indicator_));
     }
 
-    EosMethodReturnValue(ConvertToJS(buffer_, indicator_, length_, cType_));
+    EosMethodReturnValue(decoder_(buffer_, indicator_, length_));
+}
+
+"// The bound buffer and indicator are read by the driver while the statement executes,
+// and a new value may replace the buffer. Throws and returns false if the statement 
+// has operations queued or running.
+bool Parameter::CheckNotExecuting() const {
+    if (statement_ && statement_->IsBusy()) {
+        NanThrowError("The parameter's value cannot be changed while its statement is busy");
+        return false;
+    }
+
+    return true;
 }
 
 NAN_SETTER(Parameter::SetValue) {
+    if (!CheckNotExecuting())
+        return;
+
     if (value->IsNull()) {
         indicator_ = SQL_NULL_DATA;
         return;
     }
 
+    if (statement_ && !dataAtExec_ && (inOutType_ == SQL_PARAM_INPUT || inOutType_ == SQL_PARAM_INPUT_OUTPUT)) {
+        SetBoundInputValue(value);
+        return;
+    }
+
     if (bufferObject_.IsEmpty()) {
 	Local<Object> buf = NanNew(bufferObject_);
         if (AllocateBoundInputParameter(cType_, value, buffer_, length_, buf)) {
@@ -278,11 +335,104 @@ NAN_SETTER(Parameter::SetValue) {
     }
 }
 
+// Writes a value into the buffer of a bound input parameter, growing the buffer if
+// necessary. Throws and returns false on failure.
+bool Parameter::SetBoundInputValue(Handle<Value> value) {
+    auto fixedLength = GetDesiredBufferLength(cType_);
+    auto length = fixedLength ? fixedLength : GetValueLength(cType_, value);
+
+    if (length < 0) {
+        NanThrowError("Cannot place parameter value into buffer");
+        return false;
+    }
+
+    // A Buffer bound as a binary value belongs to the caller, so it is never overwritten.
+    if ((length > length_ || (cType_ == SQL_C_BINARY && !ownedBuffer_)) && !Grow(length))
+        return false;
+
+    switch (cType_) {
+    case SQL_C_CHAR: case SQL_C_WCHAR:
+        indicator_ = WriteString(cType_, value->ToString(), buffer_, length_);
+        break;
+
+    case SQL_C_BINARY: {
+        SQLPOINTER data;
+        JSBuffer::Unwrap(value.As<Object>(), data, length);
+        memcpy(buffer_, data, length);
+        indicator_ = length;
+        break;
+    }
+
+    default:
+        indicator_ = FillInputBuffer(cType_, value, buffer_, length_);
+        if (!indicator_) {
+            NanThrowError("Cannot place parameter value into buffer");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Replaces the buffer with a larger one and rebinds the parameter to it. The old buffer
+// is kept if rebinding fails.
+bool Parameter::Grow(SQLLEN length) {
+    EOS_DEBUG_METHOD_FMT(L"%i -> %i", length_, length);
+
+    // Variable length values get some room to grow, so that a series of slightly 
+    // longer values does not rebind every time.
+    auto capacity = GetDesiredBufferLength(cType_) ? length : max<SQLLEN>(max<SQLLEN>(length, length_ * 2), 64);
+
+    auto buffer = new(nothrow) char[capacity];
+    if (!buffer) {
+        NanThrowError("Out of memory allocating parameter buffer");
+        return false;
+    }
+
+    // A declared size shorter than the value would cause truncation.
+    auto columnSize = columnSize_;
+    if (cType_ == SQL_C_CHAR || cType_ == SQL_C_WCHAR || cType_ == SQL_C_BINARY) {
+        auto chars = cType_ == SQL_C_WCHAR ? length / SQLLEN(sizeof(SQLWCHAR)) : length;
+        if (columnSize && columnSize < SQLULEN(chars))
+            columnSize = chars;
+    }
+
+    auto ret = SQLBindParameter(
+        statement_->GetHandle(),
+        parameterNumber_,
+        inOutType_,
+        cType_,
+        sqlType_,
+        columnSize,
+        decimalDigits_,
+        buffer,
+        capacity,
+        &indicator_);
+
+    if (!SQL_SUCCEEDED(ret)) {
+        delete[] buffer;
+        NanThrowError(statement_->GetLastError());
+        return false;
+    }
+
+    delete[] ownedBuffer_;
+    if (!bufferObject_.IsEmpty())
+        NanDisposePersistent(bufferObject_);
+
+    ownedBuffer_ = buffer;
+    buffer_ = buffer;
+    length_ = capacity;
+    columnSize_ = columnSize;
+    return true;
+}
+
 Parameter::~Parameter() {
     EOS_DEBUG_METHOD();
 
     if (!bufferObject_.IsEmpty())
         NanDisposePersistent(bufferObject_);
+
+    delete[] ownedBuffer_;
 }
 
 namespace { ClassInitializer<Parameter> init; } 
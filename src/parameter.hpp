@@ -1,8 +1,11 @@
 #pragma once 
 
 #include "eos.hpp"
+#include "decoder.hpp"
 
 namespace Eos {
+    struct EosHandle;
+
     struct Parameter: ObjectWrap {
         Parameter(SQLUSMALLINT parameterNumber, SQLSMALLINT inOutType, SQLSMALLINT sqlType, SQLSMALLINT cType, void* buffer, SQLLEN length, Handle<Object> bufferObject, SQLLEN indicator, bool autoWrap = false);
         ~Parameter();
@@ -24,6 +27,9 @@ namespace Eos {
         NAN_GETTER(GetIndex) const;
         NAN_GETTER(GetKind) const;
 
+        NAN_GETTER(GetTimestampAsNumber) const;
+        NAN_SETTER(SetTimestampAsNumber);
+
     public:
 
         static const char* Marshal(
@@ -54,9 +60,29 @@ namespace Eos {
         const SQLLEN& Indicator() const throw() { return indicator_; }
         SQLLEN& Indicator() throw() { return indicator_; }
 
+        // A combination of ConvertOptions flags, used when reading the value.
+        int ConversionOptions() const throw() { return convertOptions_; }
+        void SetConversionOptions(int options) throw() { 
+            convertOptions_ = options; 
+            decoder_ = GetDecoder(cType_, options);
+        }
+
+        // Called once SQLBindParameter has succeeded, so that the parameter can rebind 
+        // itself when a new value does not fit in its buffer, and can refuse new values
+        // while the statement is using the buffer.
+        void SetBinding(EosHandle* statement, SQLULEN columnSize, SQLSMALLINT decimalDigits) throw() {
+            statement_ = statement;
+            columnSize_ = columnSize;
+            decimalDigits_ = decimalDigits;
+        }
+
         static Handle<FunctionTemplate> Constructor() { return NanNew(constructor_); }
 
     private:
+        bool SetBoundInputValue(Handle<Value> value);
+        bool CheckNotExecuting() const;
+        bool Grow(SQLLEN length);
+
         static Persistent<FunctionTemplate> constructor_;
 
         SQLSMALLINT sqlType_, cType_;
@@ -65,7 +91,18 @@ namespace Eos {
 
         void* buffer_;
         SQLLEN length_, indicator_;
+        int convertOptions_;
+        Decoder decoder_;
 
         Persistent<Object> bufferObject_;
+
+        // When a value does not fit in the buffer, it is replaced by one allocated here
+        // (and never by a JS Buffer), so later values of a similar size reuse it.
+        char* ownedBuffer_;
+        bool dataAtExec_;
+
+        EosHandle* statement_;
+        SQLULEN columnSize_;
+        SQLSMALLINT decimalDigits_;
     };
 }
@@ -0,0 +1,547 @@
+#include "pool.hpp"
+
+#include <cstring>
+
+using namespace Eos;
+
+WorkerPool* WorkerPool::New(uv_loop_t* loop, unsigned int maxThreads) {
+    assert(loop && maxThreads > 0 && maxThreads <= MaxMaxThreads);
+
+    auto pool = new(nothrow) WorkerPool(loop, maxThreads);
+    if (!pool)
+        return nullptr;
+
+    // Submit() relies on there always being at least one thread to fall back to.
+    if (!pool->StartWorker()) {
+        delete pool;
+        return nullptr;
+    }
+
+    return pool;
+}
+
+WorkerPool::WorkerPool(uv_loop_t* loop, unsigned int maxThreads)
+    : loop_(loop)
+    , maxThreads_(maxThreads)
+    , nextAffinity_(0)
+    , refs_(0)
+    , affinityWorkers_(maxThreads, nullptr)
+    , pollerStarted_(false)
+    , pollerStopping_(false)
+    , watchdogStarted_(false)
+    , watchdogStopping_(false)
+    , pending_(0)
+    , coalesceCallbacks_(false)
+    , asyncPolling_(false)
+{
+    EOS_DEBUG_METHOD_FMT(L"maxThreads = %u", maxThreads);
+
+    uv_mutex_init(&pollerMutex_);
+    uv_cond_init(&pollerCond_);
+    uv_mutex_init(&watchdogMutex_);
+    uv_cond_init(&watchdogCond_);
+
+    memset(&batchStats_, 0, sizeof(batchStats_));
+    memset(&pollerStats_, 0, sizeof(pollerStats_));
+
+    completedAsync_ = new uv_async_t();
+    completedAsync_->data = this;
+    uv_async_init(loop, completedAsync_, &CompletedCallback);
+    uv_unref(reinterpret_cast<uv_handle_t*>(completedAsync_));
+}
+
+WorkerPool::~WorkerPool() {
+    EOS_DEBUG_METHOD();
+
+    assert(pending_ == 0 && completed_.IsEmpty());
+
+    for (auto it = workers_.begin(); it != workers_.end(); ++it) {
+        auto worker = *it;
+
+        uv_mutex_lock(&worker->mutex);
+        worker->stopping = true;
+        uv_cond_signal(&worker->cond);
+        uv_mutex_unlock(&worker->mutex);
+
+        uv_thread_join(&worker->thread);
+
+        uv_cond_destroy(&worker->cond);
+        uv_mutex_destroy(&worker->mutex);
+        delete worker;
+    }
+
+    if (pollerStarted_) {
+        uv_mutex_lock(&pollerMutex_);
+        pollerStopping_ = true;
+        uv_cond_signal(&pollerCond_);
+        uv_mutex_unlock(&pollerMutex_);
+
+        uv_thread_join(&poller_);
+    }
+
+    uv_cond_destroy(&pollerCond_);
+    uv_mutex_destroy(&pollerMutex_);
+
+    if (watchdogStarted_) {
+        uv_mutex_lock(&watchdogMutex_);
+        watchdogStopping_ = true;
+        uv_cond_signal(&watchdogCond_);
+        uv_mutex_unlock(&watchdogMutex_);
+
+        uv_thread_join(&watchdog_);
+    }
+
+    assert(deadlines_.empty());
+    uv_cond_destroy(&watchdogCond_);
+    uv_mutex_destroy(&watchdogMutex_);
+
+    uv_close(reinterpret_cast<uv_handle_t*>(completedAsync_), &ClosedCallback);
+}
+
+void WorkerPool::Unref() {
+    assert(refs_ > 0);
+
+    if (--refs_ == 0)
+        delete this;
+}
+
+unsigned int WorkerPool::NextAffinity() {
+    auto affinity = nextAffinity_;
+    nextAffinity_ = (nextAffinity_ + 1) % maxThreads_;
+    return affinity;
+}
+
+WorkerPool::Worker* WorkerPool::StartWorker() {
+    auto worker = new(nothrow) Worker();
+    if (!worker)
+        return nullptr;
+
+    worker->pool = this;
+    worker->interactiveRun = 0;
+    worker->stopping = false;
+    memset(worker->stats, 0, sizeof(worker->stats));
+    uv_mutex_init(&worker->mutex);
+    uv_cond_init(&worker->cond);
+
+    if (uv_thread_create(&worker->thread, &WorkerMain, worker) != 0) {
+        uv_cond_destroy(&worker->cond);
+        uv_mutex_destroy(&worker->mutex);
+        delete worker;
+        return nullptr;
+    }
+
+    workers_.push_back(worker);
+    return worker;
+}
+
+void WorkerPool::Submit(unsigned int affinity, Lane lane, Task* task) {
+    EOS_DEBUG_METHOD_FMT(L"affinity = %u, lane = %i", affinity, lane);
+
+    assert(affinity < maxThreads_ && lane < LaneCount);
+
+    auto& worker = affinityWorkers_[affinity];
+    if (!worker) {
+        // Start threads up to the one this connection was given. If a thread cannot be
+        // started, fall back to one of those which are already running; New() started 
+        // the first.
+        while (workers_.size() <= affinity && StartWorker())
+            ;
+
+        assert(!workers_.empty());
+        worker = workers_[affinity % workers_.size()];
+    }
+
+    AddPending();
+    SetTimeout(task);
+
+    task->submitted_ = uv_hrtime();
+
+    uv_mutex_lock(&worker->mutex);
+    worker->lanes[lane].push_back(task);
+    worker->stats[lane].submitted++;
+    worker->stats[lane].queued++;
+    uv_cond_signal(&worker->cond);
+    uv_mutex_unlock(&worker->mutex);
+}
+
+void WorkerPool::GetLaneStats(LaneStats (&stats)[LaneCount]) {
+    memset(stats, 0, sizeof(stats));
+
+    for (auto it = workers_.begin(); it != workers_.end(); ++it) {
+        auto worker = *it;
+
+        uv_mutex_lock(&worker->mutex);
+        for (int lane = 0; lane < LaneCount; lane++) {
+            auto& from = worker->stats[lane];
+            auto& to = stats[lane];
+            to.submitted += from.submitted;
+            to.started += from.started;
+            to.totalWait += from.totalWait;
+            to.queued += from.queued;
+            if (from.maxWait > to.maxWait)
+                to.maxWait = from.maxWait;
+        }
+        uv_mutex_unlock(&worker->mutex);
+    }
+}
+
+void WorkerPool::SubmitPolled(Task* task) {
+    EOS_DEBUG_METHOD();
+
+    if (!pollerStarted_ && !StartPoller()) {
+        // Polling still works from a worker thread, it just ties one up.
+        EOS_DEBUG(L"Unable to start the polling thread\n");
+        return Submit(NextAffinity(), LaneInteractive, task);
+    }
+
+    AddPending();
+    SetTimeout(task);
+
+    uv_mutex_lock(&pollerMutex_);
+    pollerIncoming_.push_back(task);
+    uv_cond_signal(&pollerCond_);
+    uv_mutex_unlock(&pollerMutex_);
+}
+
+void WorkerPool::SubmitUrgent(Task* task) {
+    EOS_DEBUG_METHOD();
+
+    if (!watchdogStarted_ && !StartWatchdog()) {
+        // Better late than never.
+        EOS_DEBUG(L"Unable to start the watchdog thread\n");
+        return Submit(NextAffinity(), LaneInteractive, task);
+    }
+
+    AddPending();
+
+    uv_mutex_lock(&watchdogMutex_);
+    urgent_.push_back(task);
+    uv_cond_signal(&watchdogCond_);
+    uv_mutex_unlock(&watchdogMutex_);
+}
+
+bool WorkerPool::StartPoller() {
+    assert(!pollerStarted_);
+
+    if (uv_thread_create(&poller_, &PollerMain, this) != 0)
+        return false;
+
+    pollerStarted_ = true;
+    return true;
+}
+
+void WorkerPool::SetTimeout(Task* task) {
+    task->timeout_ = task->Timeout();
+
+    // Without a watchdog, the task simply runs for as long as it takes.
+    if (task->timeout_ && !watchdogStarted_ && !StartWatchdog()) {
+        EOS_DEBUG(L"Unable to start the watchdog thread\n");
+        task->timeout_ = 0;
+    }
+}
+
+bool WorkerPool::StartWatchdog() {
+    assert(!watchdogStarted_);
+
+    if (uv_thread_create(&watchdog_, &WatchdogMain, this) != 0)
+        return false;
+
+    watchdogStarted_ = true;
+    return true;
+}
+
+void WorkerPool::Watch(Task* task) {
+    if (!task->timeout_)
+        return;
+
+    Deadline deadline = { task, uv_hrtime() + task->timeout_ };
+
+    uv_mutex_lock(&watchdogMutex_);
+    deadlines_.push_back(deadline);
+    uv_cond_signal(&watchdogCond_);
+    uv_mutex_unlock(&watchdogMutex_);
+}
+
+// Once this returns, the watchdog will not call Cancel() on the task.
+void WorkerPool::Unwatch(Task* task) {
+    if (!task->timeout_)
+        return;
+
+    uv_mutex_lock(&watchdogMutex_);
+    for (std::size_t i = 0; i < deadlines_.size(); i++) {
+        if (deadlines_[i].task == task) {
+            deadlines_[i] = deadlines_.back();
+            deadlines_.pop_back();
+            break;
+        }
+    }
+    uv_mutex_unlock(&watchdogMutex_);
+}
+
+void WorkerPool::WatchdogMain(void* arg) {
+    auto pool = static_cast<WorkerPool*>(arg);
+
+    uv_mutex_lock(&pool->watchdogMutex_);
+
+    while (!pool->watchdogStopping_ || !pool->urgent_.empty()) {
+        // Urgent tasks are run without the lock, so that workers are not held up starting
+        // and finishing their own tasks meanwhile.
+        if (!pool->urgent_.empty()) {
+            std::vector<Task*> urgent;
+            urgent.swap(pool->urgent_);
+            uv_mutex_unlock(&pool->watchdogMutex_);
+
+            for (auto it = urgent.begin(); it != urgent.end(); ++it) {
+                (*it)->Run();
+                pool->Finished(*it);
+            }
+
+            uv_mutex_lock(&pool->watchdogMutex_);
+            continue;
+        }
+
+        if (pool->deadlines_.empty()) {
+            uv_cond_wait(&pool->watchdogCond_, &pool->watchdogMutex_);
+            continue;
+        }
+
+        auto now = uv_hrtime();
+        auto next = pool->deadlines_[0].due;
+
+        // Cancel() is called with the lock held, so that the task cannot be unwatched (and
+        // completed) while it is being cancelled.
+        for (std::size_t i = 0; i < pool->deadlines_.size(); ) {
+            auto& deadline = pool->deadlines_[i];
+            if (deadline.due <= now) {
+                deadline.task->Cancel();
+                deadline = pool->deadlines_.back();
+                pool->deadlines_.pop_back();
+                continue;
+            }
+
+            if (deadline.due < next)
+                next = deadline.due;
+            i++;
+        }
+
+        if (!pool->deadlines_.empty() && next > now)
+            uv_cond_timedwait(&pool->watchdogCond_, &pool->watchdogMutex_, next - now);
+    }
+
+    uv_mutex_unlock(&pool->watchdogMutex_);
+}
+
+void WorkerPool::Post(Task* task) {
+    EOS_DEBUG_METHOD();
+
+    AddPending();
+    Finished(task);
+}
+
+void WorkerPool::AddPending() {
+    if (pending_++ == 0)
+        uv_ref(reinterpret_cast<uv_handle_t*>(completedAsync_));
+}
+
+bool WorkerPool::Worker::IsIdle() const {
+    for (int lane = 0; lane < LaneCount; lane++) {
+        if (!lanes[lane].empty())
+            return false;
+    }
+    return true;
+}
+
+// Called with the worker's mutex held, when at least one lane has a task.
+WorkerPool::Task* WorkerPool::Worker::Next(uint64_t now) {
+    auto lane = LaneInteractive;
+    if (lanes[LaneInteractive].empty() 
+        || (!lanes[LaneBatch].empty() && interactiveRun >= InteractiveWeight))
+        lane = LaneBatch;
+
+    if (lane == LaneInteractive)
+        interactiveRun++;
+    else
+        interactiveRun = 0;
+
+    auto task = lanes[lane].front();
+    lanes[lane].pop_front();
+
+    auto& laneStats = stats[lane];
+    auto wait = now - task->submitted_;
+    laneStats.queued--;
+    laneStats.started++;
+    laneStats.totalWait += wait;
+    if (wait > laneStats.maxWait)
+        laneStats.maxWait = wait;
+
+    return task;
+}
+
+void WorkerPool::WorkerMain(void* arg) {
+    auto worker = static_cast<Worker*>(arg);
+    auto pool = worker->pool;
+
+    for (;;) {
+        uv_mutex_lock(&worker->mutex);
+        while (worker->IsIdle() && !worker->stopping)
+            uv_cond_wait(&worker->cond, &worker->mutex);
+
+        if (worker->IsIdle()) {
+            uv_mutex_unlock(&worker->mutex);
+            return;
+        }
+
+        auto task = worker->Next(uv_hrtime());
+        uv_mutex_unlock(&worker->mutex);
+
+        pool->Watch(task);
+        task->Run();
+        pool->Unwatch(task);
+
+        pool->Finished(task);
+    }
+}
+
+void WorkerPool::PollerMain(void* arg) {
+    auto pool = static_cast<WorkerPool*>(arg);
+    std::vector<PolledTask> polling;
+
+    // Polls are counted without the lock, and added to the pool's counters when it is 
+    // next taken.
+    uint64_t polls = 0;
+
+    for (;;) {
+        uv_mutex_lock(&pool->pollerMutex_);
+
+        pool->pollerStats_.polls += polls;
+        polls = 0;
+
+        // Sleep until a task is submitted, or one of the running tasks is due to be polled.
+        while (pool->pollerIncoming_.empty() && !pool->pollerStopping_) {
+            if (polling.empty()) {
+                uv_cond_wait(&pool->pollerCond_, &pool->pollerMutex_);
+                continue;
+            }
+
+            auto due = polling[0].due;
+            for (std::size_t i = 1; i < polling.size(); i++) {
+                if (polling[i].due < due)
+                    due = polling[i].due;
+            }
+
+            auto now = uv_hrtime();
+            if (due <= now)
+                break;
+
+            uv_cond_timedwait(&pool->pollerCond_, &pool->pollerMutex_, due - now);
+        }
+
+        if (pool->pollerStopping_ && pool->pollerIncoming_.empty() && polling.empty()) {
+            uv_mutex_unlock(&pool->pollerMutex_);
+            return;
+        }
+
+        // New tasks are started (polled for the first time) straight away.
+        for (auto it = pool->pollerIncoming_.begin(); it != pool->pollerIncoming_.end(); ++it) {
+            PolledTask polled = { *it, 0, MinPollInterval };
+            polling.push_back(polled);
+            pool->Watch(*it);
+        }
+        pool->pollerStats_.started += pool->pollerIncoming_.size();
+        pool->pollerIncoming_.clear();
+
+        uv_mutex_unlock(&pool->pollerMutex_);
+
+        auto now = uv_hrtime();
+        for (std::size_t i = 0; i < polling.size(); ) {
+            auto& polled = polling[i];
+            if (polled.due > now) {
+                i++;
+                continue;
+            }
+
+            polls++;
+            if (polled.task->Poll()) {
+                // Counted before the completion is queued, so that its callback sees it.
+                uv_mutex_lock(&pool->pollerMutex_);
+                pool->pollerStats_.completed++;
+                pool->pollerStats_.polls += polls;
+                uv_mutex_unlock(&pool->pollerMutex_);
+                polls = 0;
+
+                pool->Unwatch(polled.task);
+                pool->Finished(polled.task);
+                polling[i] = polling.back();
+                polling.pop_back();
+                continue;
+            }
+
+            polled.due = now + polled.interval;
+            if ((polled.interval *= 2) > MaxPollInterval)
+                polled.interval = MaxPollInterval;
+            i++;
+        }
+    }
+}
+
+void WorkerPool::GetPollerStats(PollerStats& stats) {
+    uv_mutex_lock(&pollerMutex_);
+    stats = pollerStats_;
+    uv_mutex_unlock(&pollerMutex_);
+}
+
+void WorkerPool::Finished(Completion* completion) {
+    // uv_async_send() is only needed when the queue was empty: otherwise it has already been
+    // called for a wakeup which has not yet drained the queue.
+    if (completed_.Push(completion))
+        uv_async_send(completedAsync_);
+}
+
+#if defined(NODE_12)
+void WorkerPool::CompletedCallback(uv_async_t* async) {
+#else
+void WorkerPool::CompletedCallback(uv_async_t* async, int) {
+#endif
+    EOS_DEBUG_METHOD();
+
+    auto pool = static_cast<WorkerPool*>(async->data);
+
+    // A callback may free the last handle using the pool.
+    pool->Ref();
+
+    // uv_async_send() calls may be coalesced, or the queue may have been drained by an
+    // earlier wakeup, so there may be any number of completions, including none.
+    auto completion = pool->completed_.PopAll();
+
+    auto batch = pool->coalesceCallbacks_ && completion && CompletionQueue::Next(completion);
+    if (batch)
+        BeginCallbackBatch();
+
+    unsigned int count = 0;
+    while (completion) {
+        assert(pool->pending_ > 0);
+        if (--pool->pending_ == 0)
+            uv_unref(reinterpret_cast<uv_handle_t*>(pool->completedAsync_));
+
+        auto next = CompletionQueue::Next(completion);
+        completion->Completed();
+        completion = next;
+        count++;
+    }
+
+    if (batch) {
+        EndCallbackBatch();
+
+        auto& stats = pool->batchStats_;
+        stats.batches++;
+        stats.callbacks += count;
+        if (count > stats.largest)
+            stats.largest = count;
+    }
+
+    pool->Unref();
+}
+
+void WorkerPool::ClosedCallback(uv_handle_t* handle) {
+    delete reinterpret_cast<uv_async_t*>(handle);
+}
@@ -0,0 +1,234 @@
+#pragma once
+
+#include "eos.hpp"
+#include "completion.hpp"
+
+#include <uv.h>
+#include <deque>
+#include <vector>
+
+namespace Eos {
+    // The threads on which ODBC calls are made. Each Environment owns a pool, so that slow
+    // queries do not hold up the libuv thread pool, which is shared with fs, dns and zlib.
+    //
+    // Every connection is given an affinity when it is created: all the operations on the
+    // connection and its statements run on that thread, in the order they were submitted.
+    // The first thread is started with the pool, and the rest lazily, one per connection,
+    // until there are maxThreads of them; after that connections share threads round-robin.
+    //
+    // Each thread has a queue for each priority lane. When both lanes have tasks waiting, 
+    // InteractiveWeight interactive tasks are run for each batch task, so that latency-
+    // sensitive operations are not stuck behind bulk work, and bulk work is not starved.
+    // Tasks are only run in submission order within a lane, so a connection and its 
+    // statements always share one.
+    //
+    // Tasks may have a timeout. A watchdog thread, started when the first such task is 
+    // submitted, calls Cancel() on any task which is still running when its time is up. The
+    // same thread runs urgent tasks, such as cancelling a running operation, which must not
+    // wait behind the tasks queued on the workers.
+    //
+    // Statements which use ODBC's asynchronous polling mode instead have their operations
+    // started and re-polled by a single polling thread, which backs off exponentially while 
+    // an operation is still executing, so that one thread can drive many statements.
+    struct WorkerPool {
+        enum Lane { LaneInteractive, LaneBatch, LaneCount };
+        enum { InteractiveWeight = 4 };
+
+        struct Task : Completion {
+            Task() : submitted_(0), timeout_(0) { }
+
+            // Called on the worker thread.
+            virtual void Run() = 0;
+
+            // Called on the polling thread, first to start the task and then until it 
+            // returns true, to check whether it has finished.
+            virtual bool Poll() { Run(); return true; }
+
+            // Called on the main thread when the task is submitted. Returns the time in 
+            // nanoseconds the task may run for, or 0 for no limit.
+            virtual uint64_t Timeout() { return 0; }
+
+            // Called on the watchdog thread when the task has run for longer than its timeout,
+            // while Run() or Poll() may be executing on another thread.
+            virtual void Cancel() { }
+
+            // Completed() is called on the main thread once Run() has returned.
+
+        private:
+            friend struct WorkerPool;
+            uint64_t submitted_, timeout_;
+        };
+
+        // Per-lane counters, for Environment.poolStats().
+        struct LaneStats {
+            uint64_t submitted, started, totalWait, maxWait;
+            unsigned int queued;
+        };
+
+        enum { DefaultMaxThreads = 16, MaxMaxThreads = 256 };
+
+        // The bounds of the delay between polls of a task, in nanoseconds. The delay starts
+        // at the minimum and doubles each time the task is found to be still executing.
+        enum { MinPollInterval = 20 * 1000, MaxPollInterval = 10 * 1000 * 1000 };
+
+        // Completions are called on the given loop, which must be the loop of the thread 
+        // creating the pool. Returns nullptr if out of memory, or if not even one worker 
+        // thread could be started.
+        static WorkerPool* New(uv_loop_t* loop, unsigned int maxThreads);
+
+        // Main thread only. The pool is created with no references, and is destroyed when 
+        // the last one is released.
+        void Ref() { refs_++; }
+        void Unref();
+
+        // Main thread: chooses the thread for a new connection.
+        unsigned int NextAffinity();
+
+        // Main thread: queues task on the thread chosen by NextAffinity(), in the given lane.
+        void Submit(unsigned int affinity, Lane lane, Task* task);
+
+        // Main thread: queues task on the polling thread, starting it if necessary.
+        void SubmitPolled(Task* task);
+
+        // Main thread: runs task on the watchdog thread, starting it if necessary. Urgent 
+        // tasks must be short, and cannot have a timeout.
+        void SubmitUrgent(Task* task);
+
+        // Main thread: calls task->Completed() on a later loop iteration, without running it.
+        // Used for operations which completed synchronously.
+        void Post(Task* task);
+
+        // Main thread: expects a completion from elsewhere (an asynchronous notification) to
+        // be passed to Finished(). The event loop is kept alive until it has been.
+        void AddPending();
+
+        // Any thread: queues a completion to be called on the main thread.
+        void Finished(Completion* completion);
+
+        // If set, the callbacks of all the tasks which complete in the same loop iteration 
+        // are called together, and the nextTick queue is only run once after them all.
+        bool CoalesceCallbacks() const { return coalesceCallbacks_; }
+        void SetCoalesceCallbacks(bool coalesce) { coalesceCallbacks_ = coalesce; }
+
+        // If set, new statements use asynchronous polling where the driver supports it.
+        bool AsyncPolling() const { return asyncPolling_; }
+        void SetAsyncPolling(bool polling) { asyncPolling_ = polling; }
+
+        uv_loop_t* Loop() const { return loop_; }
+
+        unsigned int MaxThreads() const { return maxThreads_; }
+        unsigned int ThreadCount() const { return static_cast<unsigned int>(workers_.size()); }
+
+        // Main thread: adds up the counters of every thread. Times are in nanoseconds, and 
+        // are measured from Submit() until a thread starts running the task.
+        void GetLaneStats(LaneStats (&stats)[LaneCount]);
+
+        // Counters of the groups of callbacks called together because of CoalesceCallbacks,
+        // for Environment.poolStats(). Only groups of more than one callback are counted.
+        struct BatchStats {
+            uint64_t batches, callbacks;
+            unsigned int largest;
+        };
+
+        const BatchStats& GetBatchStats() const { return batchStats_; }
+
+        // Counters of the polling thread, for Environment.poolStats(): the tasks it has 
+        // started and finished, and the number of times it has polled them.
+        struct PollerStats {
+            uint64_t started, completed, polls;
+        };
+
+        // Main thread.
+        void GetPollerStats(PollerStats& stats);
+
+    private:
+        WorkerPool(uv_loop_t* loop, unsigned int maxThreads);
+        ~WorkerPool();
+
+        struct Worker {
+            WorkerPool* pool;
+            uv_thread_t thread;
+            uv_mutex_t mutex;
+            uv_cond_t cond;
+            std::deque<Task*> lanes[LaneCount];
+            LaneStats stats[LaneCount];
+
+            // The number of interactive tasks run since the last batch task.
+            unsigned int interactiveRun;
+            bool stopping;
+
+            bool IsIdle() const;
+            Task* Next(uint64_t now);
+        };
+
+        Worker* StartWorker();
+        static void WorkerMain(void* arg);
+
+        // Any thread: starts and stops the watchdog's timer for a task, if it has a timeout.
+        void Watch(Task* task);
+        void Unwatch(Task* task);
+        void SetTimeout(Task* task);
+
+        struct Deadline {
+            Task* task;
+            uint64_t due;
+        };
+
+        bool StartWatchdog();
+        static void WatchdogMain(void* arg);
+
+        struct PolledTask {
+            Task* task;
+            uint64_t due, interval;
+        };
+
+        bool StartPoller();
+        static void PollerMain(void* arg);
+
+#if defined(NODE_12)
+        static void CompletedCallback(uv_async_t* async);
+#else
+        static void CompletedCallback(uv_async_t* async, int status);
+#endif
+        static void ClosedCallback(uv_handle_t* handle);
+
+        uv_loop_t* loop_;
+        unsigned int maxThreads_, nextAffinity_;
+        int refs_;
+        std::vector<Worker*> workers_;
+
+        // The thread each affinity was first sent to. If a thread could not be started then,
+        // the affinity stays on the fallback thread, even once more threads are running, so 
+        // that a connection's operations never run on two threads at once.
+        std::vector<Worker*> affinityWorkers_;
+
+        // The polling thread, and the tasks submitted to it which it has not yet started.
+        uv_thread_t poller_;
+        uv_mutex_t pollerMutex_;
+        uv_cond_t pollerCond_;
+        std::vector<Task*> pollerIncoming_;
+        PollerStats pollerStats_;
+        bool pollerStarted_, pollerStopping_;
+
+        // The watchdog thread, the deadlines of the running tasks which have timeouts, and 
+        // the urgent tasks it has not yet run.
+        uv_thread_t watchdog_;
+        uv_mutex_t watchdogMutex_;
+        uv_cond_t watchdogCond_;
+        std::vector<Deadline> deadlines_;
+        std::vector<Task*> urgent_;
+        bool watchdogStarted_, watchdogStopping_;
+
+        // Completions waiting to be called on the main thread, shared by the worker threads,
+        // the polling thread and asynchronous notifications.
+        uv_async_t* completedAsync_;
+        CompletionQueue completed_;
+
+        // The number of expected completions which have not yet been called. The async 
+        // handle only keeps the loop alive while this is non-zero.
+        unsigned int pending_;
+
+        bool coalesceCallbacks_, asyncPolling_;
+        BatchStats batchStats_;
+    };
+}
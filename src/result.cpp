@@ -0,0 +1,245 @@
+#include "result.hpp"
+#include "buffer.hpp"
+#include "kernels.hpp"
+
+#include <cstring>
+
+using namespace Eos;
+
+namespace {
+    // Columns of small integers are fetched as 16-bit integers, halving the size of the
+    // block compared to GetCTypeForSQLType.
+    SQLSMALLINT GetBlockCType(SQLSMALLINT sqlType) {
+        switch (sqlType) {
+        case SQL_SMALLINT: case SQL_TINYINT:
+            return SQL_C_SSHORT;
+        default:
+            return GetCTypeForSQLType(sqlType);
+        }
+    }
+
+    SQLLEN GetBlockElementLength(SQLSMALLINT cType, SQLLEN requested) {
+        if (cType == SQL_C_SSHORT)
+            return sizeof(SQLSMALLINT);
+
+        auto length = Buffers::GetDesiredBufferLength(cType);
+        if (length)
+            return length;
+
+        return requested > 0 ? requested : ResultBlock::DefaultElementLength;
+    }
+}
+
+ResultBlock::ResultBlock(SQLULEN rowCount, int convertOptions)
+    : rowCount_(rowCount)
+    , rowsFetched_(0)
+    , convertOptions_(convertOptions)
+    , busy_(false)
+{
+    EOS_DEBUG_METHOD_FMT(L"rowCount = %lu", (unsigned long)rowCount);
+}
+
+ResultBlock::~ResultBlock() {
+    EOS_DEBUG_METHOD();
+
+    for (auto it = columns_.begin(); it != columns_.end(); ++it) {
+        delete[] it->values;
+        delete[] it->indicators;
+    }
+}
+
+const char* ResultBlock::AddColumn(SQLUSMALLINT columnNumber, SQLSMALLINT sqlType, SQLLEN elementLength) {
+    Column column;
+    column.columnNumber = columnNumber;
+    column.sqlType = sqlType;
+    column.cType = GetBlockCType(sqlType);
+    column.elementLength = GetBlockElementLength(column.cType, elementLength);
+    column.decoder = GetDecoder(column.cType, convertOptions_);
+
+    if (rowCount_ > SQLULEN(INT_MAX) / column.elementLength)
+        return "The block is too large";
+
+    column.values = new(nothrow) char[column.elementLength * rowCount_];
+    column.indicators = new(nothrow) SQLLEN[rowCount_];
+
+    if (!column.values || !column.indicators) {
+        delete[] column.values;
+        delete[] column.indicators;
+        return "Out of memory allocating the block";
+    }
+
+    columns_.push_back(column);
+    return nullptr;
+}
+
+SQLRETURN ResultBlock::Bind(SQLHSTMT hStmt) {
+    EOS_DEBUG_METHOD();
+
+    auto ret = SQLSetStmtAttrW(hStmt, SQL_ATTR_ROW_BIND_TYPE, (SQLPOINTER)SQL_BIND_BY_COLUMN, SQL_IS_UINTEGER);
+    if (!SQL_SUCCEEDED(ret))
+        return ret;
+
+    ret = SQLSetStmtAttrW(hStmt, SQL_ATTR_ROW_ARRAY_SIZE, (SQLPOINTER)rowCount_, SQL_IS_UINTEGER);
+    if (!SQL_SUCCEEDED(ret))
+        return ret;
+
+    ret = SQLSetStmtAttrW(hStmt, SQL_ATTR_ROWS_FETCHED_PTR, &rowsFetched_, SQL_IS_POINTER);
+    if (!SQL_SUCCEEDED(ret))
+        return ret;
+
+    for (auto it = columns_.begin(); it != columns_.end(); ++it) {
+        ret = SQLBindCol(
+            hStmt,
+            it->columnNumber,
+            it->cType,
+            it->values, it->elementLength,
+            it->indicators);
+
+        if (!SQL_SUCCEEDED(ret))
+            return ret;
+    }
+
+    return SQL_SUCCESS;
+}
+
+SQLRETURN ResultBlock::Unbind(SQLHSTMT hStmt) {
+    EOS_DEBUG_METHOD();
+
+    auto ret = SQLFreeStmt(hStmt, SQL_UNBIND);
+    if (!SQL_SUCCEEDED(ret))
+        return ret;
+
+    ret = SQLSetStmtAttrW(hStmt, SQL_ATTR_ROWS_FETCHED_PTR, nullptr, SQL_IS_POINTER);
+    if (!SQL_SUCCEEDED(ret))
+        return ret;
+
+    return SQLSetStmtAttrW(hStmt, SQL_ATTR_ROW_ARRAY_SIZE, (SQLPOINTER)1, SQL_IS_UINTEGER);
+}
+
+bool ResultBlock::Convert(Handle<Array> values, Handle<Array> nulls) {
+    EOS_DEBUG_METHOD_FMT(L"rowsFetched = %lu", (unsigned long)rowsFetched_);
+
+    assert(rowsFetched_ <= rowCount_);
+
+    nullBitmap_.resize((rowsFetched_ + 7) / 8 + 1);
+
+    for (std::size_t i = 0; i < columns_.size(); i++) {
+        bool anyNulls = Kernels::PackNullBitmap(columns_[i].indicators, &nullBitmap_[0], rowsFetched_);
+
+        auto column = ConvertColumn(columns_[i], anyNulls);
+        if (column.IsEmpty())
+            return false;
+
+        values->Set(i, column);
+
+        if (anyNulls) {
+            SQLPOINTER data;
+            SQLLEN length = (rowsFetched_ + 7) / 8;
+            auto bitmap = JSBuffer::New(length);
+            JSBuffer::Unwrap(bitmap, data, length);
+            memcpy(data, &nullBitmap_[0], length);
+            nulls->Set(i, bitmap);
+        } else {
+            nulls->Set(i, NanNull());
+        }
+    }
+
+    return true;
+}
+
+// Assumes that nullBitmap_ has been filled in for this column.
+Handle<Value> ResultBlock::ConvertColumn(const Column& column, bool& anyNulls) {
+    auto rows = static_cast<std::size_t>(rowsFetched_);
+    double* out = nullptr;
+    Handle<Object> typedArray;
+
+    switch (column.cType) {
+    case SQL_C_SSHORT:
+        typedArray = JSFloat64Array::New(rows, out);
+        if (typedArray.IsEmpty())
+            return typedArray;
+        Kernels::WidenInt16(reinterpret_cast<const SQLSMALLINT*>(column.values), out, rows);
+        break;
+
+    case SQL_C_SLONG:
+        typedArray = JSFloat64Array::New(rows, out);
+        if (typedArray.IsEmpty())
+            return typedArray;
+        Kernels::WidenInt32(reinterpret_cast<const SQLINTEGER*>(column.values), out, rows);
+        break;
+
+    case SQL_C_DOUBLE:
+        typedArray = JSFloat64Array::New(rows, out);
+        if (typedArray.IsEmpty())
+            return typedArray;
+        memcpy(out, column.values, rows * sizeof(SQLDOUBLE));
+        break;
+
+    case SQL_C_BIT:
+        typedArray = JSFloat64Array::New(rows, out);
+        if (typedArray.IsEmpty())
+            return typedArray;
+        Kernels::NormalizeBits(reinterpret_cast<const SQLCHAR*>(column.values), out, rows);
+        break;
+
+    case SQL_C_TYPE_TIMESTAMP:
+        if (convertOptions_ & ConvertTimestampAsNumber) {
+            typedArray = JSFloat64Array::New(rows, out);
+            if (typedArray.IsEmpty())
+                return typedArray;
+            Kernels::TimestampsToEpochMs(reinterpret_cast<const SQL_TIMESTAMP_STRUCT*>(column.values), out, rows);
+        } else {
+            scratch_.resize(rows + 1);
+            Kernels::TimestampsToEpochMs(reinterpret_cast<const SQL_TIMESTAMP_STRUCT*>(column.values), &scratch_[0], rows);
+
+            auto dates = NanNew<Array>(rows);
+            for (std::size_t i = 0; i < rows; i++) {
+                if (column.indicators[i] == SQL_NULL_DATA)
+                    dates->Set(i, NanNull());
+                else
+                    dates->Set(i, NanNew<Date>(scratch_[i]));
+            }
+            return dates;
+        }
+        break;
+
+    case SQL_C_BINARY: {
+        auto buffers = NanNew<Array>(rows);
+        for (std::size_t i = 0; i < rows; i++) {
+            auto indicator = column.indicators[i];
+            if (indicator == SQL_NULL_DATA) {
+                buffers->Set(i, NanNull());
+                continue;
+            }
+
+            if (indicator == SQL_NO_TOTAL || indicator > column.elementLength)
+                indicator = column.elementLength;
+
+            SQLPOINTER data;
+            SQLLEN length = indicator;
+            auto buffer = JSBuffer::New(length);
+            JSBuffer::Unwrap(buffer, data, length);
+            memcpy(data, column.values + i * column.elementLength, indicator);
+            buffers->Set(i, buffer);
+        }
+        return buffers;
+    }
+
+    default: {
+        auto results = NanNew<Array>(rows);
+        for (std::size_t i = 0; i < rows; i++) {
+            auto indicator = column.indicators[i];
+            if (indicator == SQL_NULL_DATA)
+                results->Set(i, NanNull());
+            else
+                results->Set(i, column.decoder(column.values + i * column.elementLength, indicator, column.elementLength));
+        }
+        return results;
+    }
+    }
+
+    if (anyNulls)
+        Kernels::ApplyNullBitmap(&nullBitmap_[0], out, rows);
+
+    return typedArray;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "eos.hpp"
+#include "decoder.hpp"
+
+#include <vector>
+
+namespace Eos {
+    // A set of columns bound with column-wise binding, so that each SQLFetch retrieves
+    // up to RowCount() rows at once (see SQL_ATTR_ROW_ARRAY_SIZE). Each column has one
+    // contiguous array of values and one array of length/indicator values.
+    struct ResultBlock {
+        ResultBlock(SQLULEN rowCount, int convertOptions);
+        ~ResultBlock();
+
+        // The buffer size for each value of a variable-length column, if none is given.
+        enum { DefaultElementLength = 512 };
+
+        // Adds a column to be bound. elementLength is only used for variable-length
+        // types, and is the size in bytes of the buffer for each value (0 for the default).
+        // Returns an error message on failure.
+        const char* AddColumn(SQLUSMALLINT columnNumber, SQLSMALLINT sqlType, SQLLEN elementLength);
+
+        // Sets the statement attributes for block fetching and binds the columns.
+        SQLRETURN Bind(SQLHSTMT hStmt);
+
+        // Unbinds all columns and restores the statement to fetching one row at a time.
+        static SQLRETURN Unbind(SQLHSTMT hStmt);
+
+        // Converts the rows retrieved by the last SQLFetch into one value per column (a 
+        // Float64Array for numeric columns, and an Array otherwise) and one null bitmap per 
+        // column (a Buffer with one bit per row, or null if the column contained no nulls).
+        // Returns false, with an exception pending, if an array could not be created.
+        bool Convert(Handle<Array> values, Handle<Array> nulls);
+
+        SQLULEN RowCount() const { return rowCount_; }
+        SQLULEN RowsFetched() const { return rowsFetched_; }
+
+        // Set while a FetchBlockOperation is using the buffers.
+        bool IsBusy() const { return busy_; }
+        void SetBusy(bool busy) { busy_ = busy; }
+
+    private:
+        ResultBlock(const ResultBlock&); // = delete
+        void operator=(const ResultBlock&); // = delete
+
+        struct Column {
+            SQLUSMALLINT columnNumber;
+            SQLSMALLINT sqlType, cType;
+            SQLLEN elementLength;
+            char* values;
+            SQLLEN* indicators;
+            Decoder decoder;
+        };
+
+        Handle<Value> ConvertColumn(const Column& column, bool& anyNulls);
+
+        std::vector<Column> columns_;
+        std::vector<unsigned char> nullBitmap_;
+        std::vector<double> scratch_;
+        SQLULEN rowCount_, rowsFetched_;
+        int convertOptions_;
+        bool busy_;
+    };
+}
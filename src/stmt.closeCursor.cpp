@@ -0,0 +1,72 @@
+#include "stmt.hpp"
+
+using namespace Eos;
+
+namespace Eos {
+    struct CloseCursorOperation : Operation<Statement, CloseCursorOperation> {
+        // Neither SQLCloseCursor nor SQLFreeStmt can be run asynchronously.
+        enum { Pollable = false, AsyncCapable = false };
+
+        CloseCursorOperation(bool throwOnNoCursor)
+            : throwOnNoCursor_(throwOnNoCursor)
+        {
+            EOS_DEBUG_METHOD();
+        }
+
+        static EOS_OPERATION_CONSTRUCTOR(New, Statement) {
+            EOS_DEBUG_METHOD();
+
+            if (args.Length() < 3)
+                return NanError("Too few arguments");
+
+            (new CloseCursorOperation(args[1]->IsTrue()))->Wrap(args.Holder());
+
+            EOS_OPERATION_CONSTRUCTOR_RETURN();
+        }
+
+        static const char* Name() { return "CloseCursorOperation"; }
+
+    protected:
+        SQLRETURN CallOverride() {
+            EOS_DEBUG_METHOD();
+
+            if (throwOnNoCursor_)
+                return SQLCloseCursor(Owner()->GetHandle());
+
+            return SQLFreeStmt(Owner()->GetHandle(), SQL_CLOSE);
+        }
+
+    private:
+        bool throwOnNoCursor_;
+    };
+}
+
+NAN_METHOD(Statement::CloseCursor) {
+    EOS_DEBUG_METHOD();
+
+    // With a callback, the cursor is closed on the worker thread after the operations queued
+    // on the statement, since the driver may have to read the rest of the results first.
+    if (args.Length() > 1 && args[1]->IsFunction()) {
+        Handle<Value> argv[] = { NanObjectWrapHandle(this), args[0], args[1] };
+        return Begin<CloseCursorOperation>(argv);
+    }
+    
+    if (args.Length() > 0 && args[0]->IsFunction()) {
+        Handle<Value> argv[] = { NanObjectWrapHandle(this), NanFalse(), args[0] };
+        return Begin<CloseCursorOperation>(argv);
+    }
+
+    SQLRETURN ret;
+    if (args.Length() > 0 && args[0]->IsTrue())
+        ret = SQLCloseCursor(GetHandle()); // Can fail if no open cursor
+    else
+        ret = SQLFreeStmt(GetHandle(), SQL_CLOSE); // No error if no cursor
+
+    if(!SQL_SUCCEEDED(ret))
+        return NanThrowError(GetLastError());
+
+    NanReturnUndefined();
+}
+
+template<> Persistent<FunctionTemplate> Operation<Statement, CloseCursorOperation>::constructor_ = Persistent<FunctionTemplate>();
+namespace { ClassInitializer<CloseCursorOperation> ci; }
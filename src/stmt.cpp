@@ -1,11 +1,76 @@
 #include "stmt.hpp"
 #include "parameter.hpp"
+#include "paramblock.hpp"
 #include "buffer.hpp"
+#include "result.hpp"
+
+#include <utility>
 
 using namespace Eos;
 
 Persistent<FunctionTemplate> Statement::constructor_;
 
+namespace {
+    // Turns on asynchronous execution for polling, if the driver supports it for each 
+    // statement independently. Drivers which only support it per connection (SQL_AM_CONNECTION)
+    // would make every other statement on the connection asynchronous too.
+    bool EnableAsyncPolling(Connection* conn, SQLHSTMT hStmt) {
+        SQLUINTEGER asyncMode = SQL_AM_NONE;
+        auto ret = SQLGetInfoW(conn->GetHandle(), SQL_ASYNC_MODE, &asyncMode, sizeof(asyncMode), nullptr);
+        if (!SQL_SUCCEEDED(ret) || asyncMode != SQL_AM_STATEMENT)
+            return false;
+
+        ret = SQLSetStmtAttrW(
+            hStmt,
+            SQL_ATTR_ASYNC_ENABLE,
+            (SQLPOINTER)SQL_ASYNC_ENABLE_ON,
+            SQL_IS_UINTEGER);
+
+        return SQL_SUCCEEDED(ret);
+    }
+
+    // Cancels a statement's running operation from the pool's watchdog thread, since the 
+    // statement's own thread is busy running it.
+    struct CancelTask : WorkerPool::Task {
+        // The task counts against the statement, so that the handle cannot be freed or 
+        // swapped while it runs.
+        CancelTask(Statement* stmt, Handle<Function> callback)
+            : stmt_(stmt)
+            , ret_(SQL_SUCCESS)
+        {
+            stmt_->Ref();
+            stmt_->TaskStarted();
+            NanAssignPersistent(callback_, callback);
+        }
+
+        void Run() {
+            ret_ = SQLCancelHandle(SQL_HANDLE_STMT, stmt_->GetHandle());
+        }
+
+        void Completed() {
+            NanScope();
+
+            auto callback = NanNew(callback_);
+            NanDisposePersistent(callback_);
+
+            Handle<Value> argv[] = { NanUndefined() };
+            if (!SQL_SUCCEEDED(ret_))
+                argv[0] = stmt_->GetLastError();
+
+            stmt_->TaskFinished();
+            MakeCompletionCallback(NanObjectWrapHandle(stmt_), callback, 1, argv);
+
+            stmt_->Unref();
+            delete this;
+        }
+
+    private:
+        Statement* stmt_;
+        SQLRETURN ret_;
+        Persistent<Function> callback_;
+    };
+}
+
 void Statement::Init(Handle<Object> exports) {
     EOS_DEBUG_METHOD();
 
@@ -15,6 +80,8 @@ void Statement::Init(Handle<Object> exports) {
     EOS_SET_METHOD(Constructor(), "prepare", Statement, Prepare, sig0);
     EOS_SET_METHOD(Constructor(), "execDirect", Statement, ExecDirect, sig0);
     EOS_SET_METHOD(Constructor(), "execute", Statement, Execute, sig0);
+    EOS_SET_METHOD(Constructor(), "executeBatch", Statement, ExecuteBatch, sig0);
+    EOS_SET_METHOD(Constructor(), "executeColumns", Statement, ExecuteColumns, sig0);
     EOS_SET_METHOD(Constructor(), "fetch", Statement, Fetch, sig0);
     EOS_SET_METHOD(Constructor(), "getData", Statement, GetData, sig0);
     EOS_SET_METHOD(Constructor(), "cancel", Statement, Cancel, sig0);
@@ -22,14 +89,27 @@ void Statement::Init(Handle<Object> exports) {
     EOS_SET_METHOD(Constructor(), "describeCol", Statement, DescribeCol, sig0);
     EOS_SET_METHOD(Constructor(), "paramData", Statement, ParamData, sig0);
     EOS_SET_METHOD(Constructor(), "putData", Statement, PutData, sig0);
+    EOS_SET_METHOD(Constructor(), "putDataStream", Statement, PutDataStream, sig0);
     EOS_SET_METHOD(Constructor(), "moreResults", Statement, MoreResults, sig0);
     EOS_SET_METHOD(Constructor(), "bindParameter", Statement, BindParameter, sig0);
     EOS_SET_METHOD(Constructor(), "setParameterName", Statement, SetParameterName, sig0);
     EOS_SET_METHOD(Constructor(), "unbindParameters", Statement, UnbindParameters, sig0);
+    EOS_SET_METHOD(Constructor(), "bindParameters", Statement, BindParameters, sig0);
     EOS_SET_METHOD(Constructor(), "bindCol", Statement, BindCol, sig0);
     EOS_SET_METHOD(Constructor(), "unbindColumn", Statement, UnbindColumn, sig0);
     EOS_SET_METHOD(Constructor(), "unbindColumns", Statement, UnbindColumns, sig0);
+    EOS_SET_METHOD(Constructor(), "bindBlock", Statement, BindBlock, sig0);
+    EOS_SET_METHOD(Constructor(), "fetchBlock", Statement, FetchBlock, sig0);
+    EOS_SET_METHOD(Constructor(), "unbindBlock", Statement, UnbindBlock, sig0);
     EOS_SET_METHOD(Constructor(), "closeCursor", Statement, CloseCursor, sig0);
+    EOS_SET_METHOD(Constructor(), "release", Statement, Release, sig0);
+    EOS_SET_ACCESSOR(Constructor(), "timestampsAsNumbers", Statement, GetTimestampsAsNumbers, SetTimestampsAsNumbers);
+    EOS_SET_GETTER(Constructor(), "parameterDescriptions", Statement, GetParameterDescriptions);
+    EOS_SET_GETTER(Constructor(), "asyncPolling", Statement, GetAsyncPolling);
+    EOS_SET_ACCESSOR(Constructor(), "timeout", Statement, GetTimeout, SetTimeout);
+
+    // Exported so that lib/ can add methods implemented in JavaScript.
+    exports->Set(NanSymbol("Statement"), Constructor()->GetFunction() IF_NODE_12(EOS_COMMA ReadOnly));
 }
 
 NAN_METHOD(Statement::New) {
@@ -52,10 +132,16 @@ NAN_METHOD(Statement::New) {
     auto conn = ObjectWrap::Unwrap<Connection>(args[0]->ToObject());
     
     SQLHSTMT hStmt;
+    SQLRETURN ret;
 
-    auto ret = SQLAllocHandle(SQL_HANDLE_STMT, conn->GetHandle(), &hStmt);
-    if (!SQL_SUCCEEDED(ret))
-        return NanThrowError(conn->GetLastError());
+    // Connection.newStatement(callback) allocates the handle on the connection's thread.
+    if (args.Length() > 1 && args[1]->IsExternal()) {
+        hStmt = static_cast<SQLHSTMT>(args[1].As<External>()->Value());
+    } else {
+        ret = SQLAllocHandle(SQL_HANDLE_STMT, conn->GetHandle(), &hStmt);
+        if (!SQL_SUCCEEDED(ret))
+            return NanThrowError(conn->GetLastError());
+    }
 
 #if defined(EOS_ENABLE_ASYNC_NOTIFICATIONS)
     HANDLE hEvent = nullptr;
@@ -88,7 +174,18 @@ NAN_METHOD(Statement::New) {
     }
 #endif
 
-    (new Statement(hStmt, conn EOS_ASYNC_ONLY_ARG(hEvent)))->Wrap(args.Holder());
+    auto polling = conn->Pool()->AsyncPolling();
+#if defined(EOS_ENABLE_ASYNC_NOTIFICATIONS)
+    if (hEvent)
+        polling = false;
+#endif
+
+    // Statements run on their connection's thread, unless they are polled.
+    auto stmt = new Statement(hStmt, conn EOS_ASYNC_ONLY_ARG(hEvent));
+    stmt->SetPool(conn->Pool(), conn->Affinity());
+    if (polling && EnableAsyncPolling(conn, hStmt))
+        stmt->SetAsyncPolling();
+    stmt->Wrap(args.Holder());
     
     NanReturnValue(args.Holder());
 }
@@ -96,19 +193,108 @@ NAN_METHOD(Statement::New) {
 Statement::Statement(SQLHSTMT hStmt, Connection* conn EOS_ASYNC_ONLY_ARG(HANDLE hEvent)) 
     : EosHandle(SQL_HANDLE_STMT, hStmt EOS_ASYNC_ONLY_ARG(hEvent))
     , connection_(conn)
+    , convertOptions_(ConvertDefault)
+    , resultBlock_(nullptr)
+    , autoPrepared_(false)
 {
     EOS_DEBUG_METHOD();
+
+    conn->AddStatement(this);
+}
+
+NAN_GETTER(Statement::GetTimestampsAsNumbers) const {
+    EosMethodReturnValue(NanNew<Boolean>((convertOptions_ & ConvertTimestampAsNumber) != 0));
+}
+
+NAN_SETTER(Statement::SetTimestampsAsNumbers) {
+    if (value->BooleanValue())
+        convertOptions_ |= ConvertTimestampAsNumber;
+    else
+        convertOptions_ &= ~ConvertTimestampAsNumber;
+}
+
+NAN_GETTER(Statement::GetAsyncPolling) const {
+    EosMethodReturnValue(NanNew<Boolean>(AsyncPolling()));
+}
+
+NAN_GETTER(Statement::GetTimeout) const {
+    EosMethodReturnValue(NanNew<Number>(OperationTimeout()));
+}
+
+NAN_SETTER(Statement::SetTimeout) {
+    if (!value->IsUint32()) {
+        NanThrowRangeError("The timeout must be a non-negative number of milliseconds");
+        return;
+    }
+
+    if (IsBusy()) {
+        NanThrowError("The timeout cannot be changed while operations are in progress");
+        return;
+    }
+
+    if (!IsValid()) {
+        NanThrowError("This handle has been freed.");
+        return;
+    }
+
+    auto timeout = value->Uint32Value();
+
+    // The driver's own timeout is in whole seconds. Not every driver supports it, in which
+    // case only the watchdog enforces the timeout.
+    SQLULEN seconds = (timeout + 999) / 1000;
+    auto ret = SQLSetStmtAttrW(GetHandle(), SQL_ATTR_QUERY_TIMEOUT, (SQLPOINTER)seconds, SQL_IS_UINTEGER);
+    if (!SQL_SUCCEEDED(ret))
+        EOS_DEBUG(L"Unable to set SQL_ATTR_QUERY_TIMEOUT\n");
+
+    SetOperationTimeout(timeout);
+}
+
+NAN_GETTER(Statement::GetParameterDescriptions) const {
+    if (paramDescriptions_.empty())
+        NanReturnUndefined();
+
+    auto result = NanNew<Array>(static_cast<int>(paramDescriptions_.size()));
+    for (std::size_t i = 0; i < paramDescriptions_.size(); i++) {
+        auto& desc = paramDescriptions_[i];
+        auto obj = NanNew<Object>();
+        obj->Set(NanSymbol("type"), NanNew<Integer>(desc.sqlType));
+        obj->Set(NanSymbol("columnSize"), NanNew<Number>(static_cast<double>(desc.columnSize)));
+        obj->Set(NanSymbol("decimalDigits"), NanNew<Integer>(desc.decimalDigits));
+        obj->Set(NanSymbol("nullable"), NanNew<Boolean>(desc.nullable == SQL_NULLABLE));
+        result->Set(i, obj);
+    }
+
+    EosMethodReturnValue(result);
 }
 
 NAN_METHOD(Statement::Cancel) {
     EOS_DEBUG_METHOD();
 
+    if (args.Length() > 0 && args[0]->IsFunction()) {
+        if (!IsValid())
+            return NanThrowError("This handle has been freed.");
+
+        auto task = new(nothrow) CancelTask(this, args[0].As<Function>());
+        if (!task)
+            return NanThrowError("Out of memory allocating the operation");
+
+        Pool()->SubmitUrgent(task);
+        NanReturnUndefined();
+    }
+
     if(!SQL_SUCCEEDED(SQLCancelHandle(SQL_HANDLE_STMT, GetHandle())))
         return NanThrowError(GetLastError());
 
     NanReturnUndefined();
 }
 
+NAN_METHOD(Statement::BeginFree) {
+    EOS_DEBUG_METHOD();
+
+    Handle<Value> argv[] = { NanObjectWrapHandle(this), args[0] };
+    return Begin<FreeOperation<Statement> >(argv);
+}
+
 NAN_METHOD(Statement::BindParameter) {
     EOS_DEBUG_METHOD();
     
@@ -121,8 +307,8 @@ NAN_METHOD(Statement::BindParameter) {
     if (!args[1]->IsInt32())
         return NanThrowTypeError("The 2nd argument should be an integer");
 
-    if (!args[2]->IsInt32())
-        return NanThrowTypeError("The 3rd argument should be an integer");
+    if (!args[2]->IsInt32() && !args[2]->IsNull() && !args[2]->IsUndefined())
+        return NanThrowTypeError("The 3rd argument should be an integer, or null to use the described type");
 
     // 0. parameter number (e.g. 2)
     // 1. parameter kind (e.g. SQL_PARAM_INPUT)
@@ -141,7 +327,7 @@ NAN_METHOD(Statement::BindParameter) {
 
     // max digits for SQL_DECIMAL, SQL_NUMERIC, SQL_FLOAT, SQL_REAL, or SQL_DOUBLE
     // max length for SQL_*CHAR, SQL_*BINARY
-    SQLSMALLINT columnSize = args[3]->Int32Value();
+    SQLULEN columnSize = args[3]->Int32Value();
     if (args[3]->Int32Value() > SHRT_MAX)
         return NanThrowRangeError("Column size is too high");
 
@@ -150,6 +336,21 @@ NAN_METHOD(Statement::BindParameter) {
     if (auto j = args[4]->Int32Value() > SHRT_MAX)
         return NanThrowRangeError("Decimal digits is too high");
 
+    // Without a type, use the one cached by prepare(sql, true, ...), along with its 
+    // size and digits unless they were given.
+    bool described = !args[2]->IsInt32();
+    if (described) {
+        auto desc = GetParameterDescription(parameterNumber);
+        if (!desc)
+            return NanThrowError("No SQL type was given, and the parameter has not been described (pass true for describeParams to prepare)");
+
+        sqlType = desc->sqlType;
+        if (!args[3]->IsInt32())
+            columnSize = desc->columnSize;
+        if (!args[4]->IsInt32())
+            decimalDigits = desc->decimalDigits;
+    }
+
     Handle<Value> jsValue = NanUndefined();
     Handle<Object> bufferObject;
 
@@ -174,6 +375,7 @@ NAN_METHOD(Statement::BindParameter) {
 
     // Setting the column length is only necessary for these types.
     if (!args[3]->IsInt32() 
+        && !described
         && !jsValue->IsUndefined() // Not data-at-execution
         && (sqlType == SQL_BINARY || sqlType == SQL_CHAR)) {
 
@@ -198,6 +400,9 @@ NAN_METHOD(Statement::BindParameter) {
     if (!SQL_SUCCEEDED(ret))
         return NanThrowError(GetLastError());
   
+    if (!dae)
+        param->SetBinding(this, columnSize, decimalDigits);
+
     Statement::AddBoundParameter(param);
 
     EosMethodReturnValue(jsParam);
@@ -209,6 +414,14 @@ void Statement::AddBoundParameter(Parameter* param) {
     if (boundParameters_.IsEmpty())
         NanAssignPersistent(boundParameters_, NanNew<Array>());
 
+    // The block, if any, no longer has all of its parameters bound, but stays alive until 
+    // the parameters are reset, as the rest still are.
+    DetachParameterBlock();
+
+    // The parameter being replaced is no longer bound.
+    if (auto previous = GetBoundParameter(param->ParameterNumber()))
+        previous->SetBinding(nullptr, 0, 0);
+
     NanNew(boundParameters_)->Set(param->ParameterNumber(), NanObjectWrapHandle(param));
 }
 
@@ -266,12 +479,96 @@ Parameter* Statement::GetBoundParameter(SQLUSMALLINT parameterNumber) {
 NAN_METHOD(Statement::UnbindParameters) {
     EOS_DEBUG_METHOD();
 
-    if(!SQL_SUCCEEDED(SQLFreeStmt(GetHandle(), SQL_RESET_PARAMS)))
+    if (!ResetParameters())
         return NanThrowError(GetLastError());
 
+    NanReturnUndefined();
+}
+
+bool Statement::ResetParameters() {
+    EOS_DEBUG_METHOD();
+
+    if(!SQL_SUCCEEDED(SQLFreeStmt(GetHandle(), SQL_RESET_PARAMS)))
+        return false;
+
+    ForgetParameterBindings();
+
 	NanDisposePersistent(boundParameters_);
+    NanDisposePersistent(parameterBlock_);
+    return true;
+}
 
-    NanReturnUndefined();
+// Stops Parameters which are no longer bound (or whose statement is being freed) from
+// rebinding themselves when their buffers grow.
+void Statement::ForgetParameterBindings() {
+    DetachParameterBlock();
+
+    if (boundParameters_.IsEmpty())
+        return;
+
+    NanScope();
+
+    auto params = NanNew(boundParameters_);
+    for (uint32_t i = 0; i < params->Length(); i++) {
+        auto param = params->Get(i);
+        if (param->IsObject())
+            Parameter::Unwrap(param.As<Object>())->SetBinding(nullptr, 0, 0);
+    }
+}
+
+void Statement::DetachParameterBlock() {
+    if (parameterBlock_.IsEmpty())
+        return;
+
+    NanScope();
+    ObjectWrap::Unwrap<ParameterBlock>(NanNew(parameterBlock_))->Detach();
+}
+
+NAN_METHOD(Statement::BindParameters) {
+    EOS_DEBUG_METHOD();
+
+    if (args.Length() < 1 || !args[0]->IsArray())
+        return NanThrowTypeError("Statement::BindParameters() requires an array of parameter types");
+
+    if (!ResetParameters())
+        return NanThrowError(GetLastError());
+
+    // Missing types are filled in from the cached parameter descriptions.
+    auto types = args[0].As<Array>();
+    if (!paramDescriptions_.empty()) {
+        auto described = NanNew<Array>(types->Length());
+        for (uint32_t i = 0; i < types->Length(); i++) {
+            auto type = types->Get(i);
+            auto desc = GetParameterDescription(static_cast<SQLUSMALLINT>(i + 1));
+
+            if ((type->IsNull() || type->IsUndefined()) && desc) {
+                auto obj = NanNew<Object>();
+                obj->Set(NanSymbol("type"), NanNew<Integer>(desc->sqlType));
+                obj->Set(NanSymbol("columnSize"), NanNew<Number>(static_cast<double>(desc->columnSize)));
+                obj->Set(NanSymbol("decimalDigits"), NanNew<Integer>(desc->decimalDigits));
+                type = obj;
+            }
+
+            described->Set(i, type);
+        }
+        types = described;
+    }
+
+    Handle<Object> block;
+    SQLRETURN ret = SQL_SUCCESS;
+    if (auto msg = ParameterBlock::Bind(this, types, ret, block))
+        return NanThrowError(msg);
+
+    if (!SQL_SUCCEEDED(ret)) {
+        auto error = GetLastError();
+        SQLFreeStmt(GetHandle(), SQL_RESET_PARAMS);
+        return NanThrowError(error);
+    }
+
+    // The block's buffer must stay alive for as long as it is bound.
+    NanAssignPersistent(parameterBlock_, block);
+
+    EosMethodReturnValue(block);
 }
 
 NAN_METHOD(Statement::BindCol) {
@@ -291,6 +588,9 @@ NAN_METHOD(Statement::BindCol) {
         return NanThrowTypeError("The column type must be an integer");
     auto type = args[1]->Int32Value();
 
+    if (resultBlock_)
+        return NanThrowError("Cannot bind a single column while a block is bound (call unbindBlock first)");
+
     SQLPOINTER buffer;
     SQLLEN length;
     Handle<Object> jsBuffer;
@@ -317,6 +617,10 @@ NAN_METHOD(Statement::BindCol) {
     if (!param)
         return NanThrowError("Out of memory allocating parameter");
 
+    // Bound columns start off with the statement's conversion options, but can be
+    // changed individually afterwards.
+    param->SetConversionOptions(convertOptions_);
+
     auto ret = SQLBindCol(
         GetHandle(),
         columnNumber,
@@ -387,8 +691,12 @@ NAN_METHOD(Statement::UnbindColumn) {
 NAN_METHOD(Statement::UnbindColumns) {
     EOS_DEBUG_METHOD();
 
-    if(!SQL_SUCCEEDED(SQLFreeStmt(GetHandle(), SQL_UNBIND)))
+    if (resultBlock_) {
+        if (auto msg = FreeResultBlock())
+            return NanThrowError(msg);
+    } else if(!SQL_SUCCEEDED(SQLFreeStmt(GetHandle(), SQL_UNBIND))) {
         return NanThrowError(GetLastError());
+    }
 
 	// No need to dispose the Parameters here. JS-land might still have a reference to them.
 	// They'll be garbage collected if necessary.
@@ -397,34 +705,271 @@ NAN_METHOD(Statement::UnbindColumns) {
     NanReturnUndefined();
 }
 
-NAN_METHOD(Statement::CloseCursor) {
+NAN_METHOD(Statement::BindBlock) {
     EOS_DEBUG_METHOD();
 
-    SQLRETURN ret;
-    if (args.Length() > 0 && args[0]->IsTrue())
-        ret = SQLCloseCursor(GetHandle()); // Can fail if no open cursor
-    else
-        ret = SQLFreeStmt(GetHandle(), SQL_CLOSE); // No error if no cursor
+    if (args.Length() < 2)
+        return NanThrowError("Statement::BindBlock() requires an array of columns and a row count");
 
-    if(!SQL_SUCCEEDED(ret))
-        return NanThrowError(GetLastError());
+    if (!args[0]->IsArray())
+        return NanThrowTypeError("The first argument to Statement::BindBlock() must be an array of columns");
+
+    if (!args[1]->IsUint32() || args[1]->Uint32Value() == 0)
+        return NanThrowRangeError("The row count must be a positive integer");
+
+    if (resultBlock_ && resultBlock_->IsBusy())
+        return NanThrowError("Cannot bind a block while a block fetch is in progress");
+
+    auto columns = args[0].As<Array>();
+    if (columns->Length() == 0 || columns->Length() > USHRT_MAX)
+        return NanThrowRangeError("The number of columns must be between 1 and 65535");
+
+    auto block = new(nothrow) ResultBlock(args[1]->Uint32Value(), convertOptions_);
+    if (!block)
+        return NanThrowError("Out of memory allocating the block");
+
+    for (uint32_t i = 0; i < columns->Length(); i++) {
+        // Each column is either an SQL type, or { type: <SQL type>, length: <bytes per value> }.
+        auto column = columns->Get(i);
+        Handle<Value> type = column, length = NanUndefined();
+
+        if (column->IsObject()) {
+            type = column->ToObject()->Get(NanSymbol("type"));
+            length = column->ToObject()->Get(NanSymbol("length"));
+        }
+
+        if (!type->IsInt32()) {
+            delete block;
+            return NanThrowTypeError("Each column must be an SQL type, or an object with a type and length");
+        }
+
+        if (!length->IsUndefined() && (!length->IsInt32() || length->Int32Value() <= 0)) {
+            delete block;
+            return NanThrowRangeError("The column length must be a positive integer");
+        }
+
+        auto msg = block->AddColumn(
+            static_cast<SQLUSMALLINT>(i + 1),
+            static_cast<SQLSMALLINT>(type->Int32Value()),
+            length->IsUndefined() ? 0 : length->Int32Value());
+
+        if (msg) {
+            delete block;
+            return NanThrowError(msg);
+        }
+    }
+
+    // Any existing bindings would be overrun by the block fetch.
+    if (resultBlock_) {
+        if (auto msg = FreeResultBlock()) {
+            delete block;
+            return NanThrowError(msg);
+        }
+    } else {
+        if (!SQL_SUCCEEDED(SQLFreeStmt(GetHandle(), SQL_UNBIND))) {
+            delete block;
+            return NanThrowError(GetLastError());
+        }
+
+        if (!boundColumns_.IsEmpty())
+            NanDisposePersistent(boundColumns_);
+    }
+
+    if (!SQL_SUCCEEDED(block->Bind(GetHandle()))) {
+        auto error = GetLastError();
+        ResultBlock::Unbind(GetHandle());
+        delete block;
+        return NanThrowError(error);
+    }
+
+    resultBlock_ = block;
 
     NanReturnUndefined();
 }
 
+NAN_METHOD(Statement::UnbindBlock) {
+    EOS_DEBUG_METHOD();
+
+    if (auto msg = FreeResultBlock())
+        return NanThrowError(msg);
+
+    NanReturnUndefined();
+}
+
+const char* Statement::FreeResultBlock() {
+    EOS_DEBUG_METHOD();
+
+    if (!resultBlock_)
+        return nullptr;
+
+    if (resultBlock_->IsBusy())
+        return "Cannot unbind a block while a block fetch is in progress";
+
+    if (!SQL_SUCCEEDED(ResultBlock::Unbind(GetHandle())))
+        EOS_DEBUG(L"Failed to restore the statement's row array size");
+
+    delete resultBlock_;
+    resultBlock_ = nullptr;
+    return nullptr;
+}
+
 void Statement::VirtualFree() {
     EOS_DEBUG_METHOD();
 
+    ForgetParameterBindings();
+
     if (!boundParameters_.IsEmpty())
         NanDisposePersistent(boundParameters_);
 
+    if (!parameterBlock_.IsEmpty())
+        NanDisposePersistent(parameterBlock_);
+
+    if (!boundColumns_.IsEmpty())
+        NanDisposePersistent(boundColumns_);
+
+    // The statement handle is being freed, so there is no need to unbind first.
+    delete resultBlock_;
+    resultBlock_ = nullptr;
+}
+
+SQLHSTMT Statement::TakeHandle() {
+    EOS_DEBUG_METHOD();
+
+    assert(!IsBusy());
+
+    if (!IsValid())
+        return SQL_NULL_HANDLE;
+
+    auto hStmt = GetHandle();
+    VirtualFree();
+    HandleFreed();
+    preparedSql_.clear();
+    autoPrepared_ = false;
+    return hStmt;
+}
+
+void Statement::Discard() {
+    EOS_DEBUG_METHOD();
+
+    if (!IsValid())
+        return;
+
+    VirtualFree();
+    FreeHandleInBackground();
+    preparedSql_.clear();
+    autoPrepared_ = false;
+}
+
+bool Statement::AdoptCachedStatement(const SqlText& sql) {
+    EOS_DEBUG_METHOD();
+
+    if (!connection_ || CheckCanBegin() || IsBusy() || HasPendingTasks())
+        return false;
+
+    // Bindings belong to the handle, and would be lost.
+    if (!boundParameters_.IsEmpty() || !parameterBlock_.IsEmpty() || !boundColumns_.IsEmpty() || resultBlock_)
+        return false;
+
+    auto cached = connection_->TakeCachedStatement(sql);
+    if (!cached)
+        return false;
+
+    SwapHandle(cached);
+    preparedSql_.swap(cached->preparedSql_);
+    std::swap(autoPrepared_, cached->autoPrepared_);
+    paramDescriptions_.swap(cached->paramDescriptions_);
+
+    // The cached statement now has this statement's old handle. The cache's reference to
+    // it is given up once the handle is on its way to being freed.
+    cached->Discard();
+    cached->Unref();
+    return true;
+}
+
+// Statements whose SQL was prepared by autoPrepare go to the statement cache when they are 
+// freed, under a new Statement object, so that code which runs each query on a new statement
+// and frees it still reuses the prepared SQL.
+bool Statement::Recycle() {
+    EOS_DEBUG_METHOD();
+
+    if (!connection_ || !autoPrepared_ || !connection_->StatementCacheSize() || connection_->IsCached(this))
+        return false;
+
+    // If the bindings cannot be undone, the handle is simply freed.
+    if (!ResetParameters())
+        return false;
+    if (resultBlock_ ? FreeResultBlock() != nullptr : !SQL_SUCCEEDED(SQLFreeStmt(GetHandle(), SQL_UNBIND)))
+        return false;
+
+    auto conn = connection_;
+    auto sql = preparedSql_;
+    auto hStmt = TakeHandle();
+
+    // If Statement::New throws, it frees the handle itself.
+    TryCatch tc;
+    Handle<Value> ctorArgs[] = { NanObjectWrapHandle(conn), NanNew<External>(hStmt) };
+    auto stmt = Constructor()->GetFunction()->NewInstance(2, ctorArgs);
+    if (!stmt.IsEmpty()) {
+        auto recycled = ObjectWrap::Unwrap<Statement>(stmt);
+        recycled->SetPreparedSql(sql, true);
+        conn->ReleaseStatement(recycled);
+    }
+
+    return true;
+}
+
+NAN_METHOD(Statement::Release) {
+    EOS_DEBUG_METHOD();
+
+    if (!IsValid())
+        return NanThrowError("This handle has been freed.");
+
+    if (IsBusy())
+        return NanThrowError("Cannot release a statement which has operations in progress");
+
+    if (!connection_) {
+        Discard();
+        NanReturnUndefined();
+    }
+
+    // The next user of the statement starts without bindings.
+    if (!ResetParameters())
+        return NanThrowError(GetLastError());
+
+    if (resultBlock_) {
+        if (auto msg = FreeResultBlock())
+            return NanThrowError(msg);
+    } else if (!SQL_SUCCEEDED(SQLFreeStmt(GetHandle(), SQL_UNBIND))) {
+        return NanThrowError(GetLastError());
+    }
+
     if (!boundColumns_.IsEmpty())
         NanDisposePersistent(boundColumns_);
+
+    connection_->ReleaseStatement(this);
+    NanReturnUndefined();
+}
+
+void Statement::ConnectionDestroyed() {
+    SetPriority(connection_->Priority());
+    connection_ = nullptr;
+}
+
+WorkerPool::Lane Statement::Priority() const {
+    return connection_ ? connection_->Priority() : EosHandle::Priority();
+}
+
+bool Statement::CheckPriorityChange() {
+    NanThrowError("A statement runs in its connection's lane; set the connection's priority instead");
+    return false;
 }
 
 Statement::~Statement() {
     EOS_DEBUG_METHOD();
 	
+    if (connection_)
+        connection_->RemoveStatement(this);
+
     VirtualFree();
 }
 
@@ -458,4 +1003,7 @@ void Statement::DisableAsynchronousNotifications() {
 }
 #endif
 
+template<> Persistent<FunctionTemplate> Operation<Statement, FreeOperation<Statement> >::constructor_ = Persistent<FunctionTemplate>();
+
 namespace { ClassInitializer<Statement> c; }
+namespace { ClassInitializer<FreeOperation<Statement> > cf; }
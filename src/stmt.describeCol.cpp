@@ -85,10 +85,10 @@ namespace Eos {
 NAN_METHOD(Statement::DescribeCol) {
     EOS_DEBUG_METHOD();
 
-    if (args.Length() < 2)
+    if (args.Length() < 1)
         return NanThrowError(
             "Statement::DescribeCol() requires a column number"
-            "(starting from 1, or 0 for the bookmark column) a callback");
+            "(starting from 1, or 0 for the bookmark column)");
 
     Handle<Value> argv[] = { NanObjectWrapHandle(this), args[0], args[1] };
     return Begin<DescribeColOperation>(argv);
@@ -4,40 +4,99 @@ using namespace Eos;
 
 namespace Eos {
     struct ExecDirectOperation : Operation<Statement, ExecDirectOperation> {
-        ExecDirectOperation(Handle<Value> sql)
+        // With autoPrepare, SQL which is executed often is prepared instead (Prepare), and 
+        // then executed again without being prepared while the statement still has it 
+        // (Reuse, or Prepare).
+        enum Mode { Direct, Reuse, Prepare };
+
+        ExecDirectOperation(Handle<Value> sql, Mode mode, bool closeCursor)
             : sql_(sql)
+            , mode_(mode)
+            , plan_(Undecided)
+            , closeCursor_(closeCursor)
+            , prepared_(false)
         {
-            EOS_DEBUG_METHOD_FMT(L"execDirect: %ls\n", *sql_);
+            EOS_DEBUG_METHOD_FMT(L"execDirect: %ls (mode %i)\n", *sql_, mode);
         }
 
         static EOS_OPERATION_CONSTRUCTOR(New, Statement) {
             EOS_DEBUG_METHOD();
 
-            if (args.Length() < 3)
+            if (args.Length() < 5)
                 return NanError("Too few arguments");
 
             if (!args[1]->IsString())
                 return NanTypeError("Statement SQL should be a string");
 
-            (new ExecDirectOperation(args[1]))->Wrap(args.Holder());
+            (new ExecDirectOperation(args[1], static_cast<Mode>(args[2]->Int32Value()), args[3]->BooleanValue()))->Wrap(args.Holder());
 
             EOS_OPERATION_CONSTRUCTOR_RETURN();
         }
 
         static const char* Name() { return "ExecDirectOperation"; }
 
+#if defined(EOS_ENABLE_ASYNC_NOTIFICATIONS)
+        // SQLCompleteAsync can only complete the last call.
+        bool IsAsyncCapable() const {
+            return mode_ != Prepare && !closeCursor_;
+        }
+#endif
+
     protected:
         SQLRETURN CallOverride() {
             EOS_DEBUG_METHOD();
 
-            return SQLExecDirectW(
-                Owner()->GetHandle(), 
-                *sql_, sql_.length());
+            auto hStmt = Owner()->GetHandle();
+
+            // Decided here rather than when the operation was begun, since the operations
+            // queued before it may have prepared other SQL, or failed to prepare this.
+            if (plan_ == Undecided) {
+                // A statement taken from the statement cache may have a cursor left open.
+                if (closeCursor_) {
+                    auto ret = SQLFreeStmt(hStmt, SQL_CLOSE);
+                    if (!SQL_SUCCEEDED(ret))
+                        return ret;
+                }
+
+                if (mode_ != Direct && Owner()->PreparedSql() == SqlText(*sql_, sql_.length()))
+                    plan_ = ExecutePrepared;
+                else if (mode_ == Prepare)
+                    plan_ = PrepareAndExecute;
+                else
+                    plan_ = ExecuteDirectly;
+            }
+
+            if (plan_ == ExecuteDirectly)
+                return SQLExecDirectW(hStmt, *sql_, sql_.length());
+
+            // When polled, this is called again until each call stops returning 
+            // SQL_STILL_EXECUTING, so the prepare is only repeated until it finishes.
+            if (plan_ == PrepareAndExecute && !prepared_) {
+                auto ret = SQLPrepareW(hStmt, *sql_, sql_.length());
+                if (!SQL_SUCCEEDED(ret))
+                    return ret;
+                prepared_ = true;
+            }
+
+            return SQLExecute(hStmt);
         }
 
         void CallbackOverride(SQLRETURN ret) {
             EOS_DEBUG_METHOD();
 
+            auto conn = Owner()->GetConnection();
+
+            // SQLExecDirect replaces the prepared statement, as does a failed prepare.
+            if (plan_ == ExecuteDirectly || (plan_ == PrepareAndExecute && !prepared_)) {
+                Owner()->SetPreparedSql(SqlText());
+            } else if (plan_ == PrepareAndExecute) {
+                Owner()->SetPreparedSql(SqlText(*sql_, sql_.length()), true);
+                if (conn)
+                    conn->CacheCounters().autoPrepared++;
+            } else if (plan_ == ExecutePrepared && conn) {
+                conn->CacheCounters().hits++;
+            }
+
             if (!SQL_SUCCEEDED(ret) && ret != SQL_NEED_DATA && ret != SQL_PARAM_DATA_AVAILABLE)
                 return CallbackErrorOverride(ret);
 
@@ -53,17 +112,45 @@ namespace Eos {
         }
 
     protected:
+        enum Plan { Undecided, ExecuteDirectly, PrepareAndExecute, ExecutePrepared };
+
         WStringValue sql_;
+        Mode mode_;
+        Plan plan_;
+        bool closeCursor_, prepared_;
     };
 }
 
 NAN_METHOD(Statement::ExecDirect) {
     EOS_DEBUG_METHOD();
 
-    if (args.Length() < 2)
-        return NanThrowError("Statement::ExecDirect() requires 2 arguments");
+    if (args.Length() < 1)
+        return NanThrowError("Statement::ExecDirect() requires an SQL string");
+
+    auto mode = ExecDirectOperation::Direct;
+    auto adopted = false;
+
+    if (connection_ && connection_->AutoPrepare() && args[0]->IsString()) {
+        WStringValue value(args[0]);
+        SqlText sql(*value, value.length());
 
-    Handle<Value> argv[] = { NanObjectWrapHandle(this), args[0], args[1] };
+        // The prepared SQL is only current while no operations are queued, so whether it 
+        // is still prepared is checked again on the worker thread.
+        mode = ExecDirectOperation::Reuse;
+        if (IsBusy() || sql != preparedSql_) {
+            adopted = AdoptCachedStatement(sql);
+            if (!adopted && connection_->ShouldAutoPrepare(sql))
+                mode = ExecDirectOperation::Prepare;
+        }
+    }
+
+    Handle<Value> argv[] = { 
+        NanObjectWrapHandle(this), 
+        args[0], 
+        NanNew<Integer>(static_cast<int32_t>(mode)), 
+        adopted ? NanTrue() : NanFalse(),
+        args[1] 
+    };
     return Begin<ExecDirectOperation>(argv);
 }
 
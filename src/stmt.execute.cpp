@@ -50,11 +50,13 @@ namespace Eos {
 NAN_METHOD(Statement::Execute) {
     EOS_DEBUG_METHOD();
 
-    if (args.Length() < 1)
-        return NanThrowError("Statement::Execute() requires a callback");
-    
-    Handle<Value> argv[] = { NanObjectWrapHandle(this), args[0] };
-    return Begin<ExecuteOperation>(argv);
+    if (!IOperation::IsCallback(args[0]))
+        return NanThrowTypeError("Last argument should be a callback function");
+
+    if (auto msg = CheckCanBegin())
+        return NanThrowError(msg);
+
+    return BeginPooled(ExecuteOperation::Acquire(this, args[0]));
 }
 
 template<> Persistent<FunctionTemplate> Operation<Statement, ExecuteOperation>::constructor_ = Persistent<FunctionTemplate>();
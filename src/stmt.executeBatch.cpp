@@ -0,0 +1,196 @@
+#include "stmt.hpp"
+#include "paramarray.hpp"
+
+using namespace Eos;
+
+namespace Eos {
+    struct ExecuteBatchOperation : Operation<Statement, ExecuteBatchOperation> {
+        ExecuteBatchOperation(ParameterArray* params)
+            : params_(params)
+        {
+            EOS_DEBUG_METHOD();
+        }
+
+        ~ExecuteBatchOperation() {
+            EOS_DEBUG_METHOD();
+
+            delete params_;
+        }
+
+        static EOS_OPERATION_CONSTRUCTOR(New, Statement) {
+            EOS_DEBUG_METHOD();
+
+            if (args.Length() < 3)
+                return NanError("Too few arguments");
+
+            if (!args[1]->IsArray())
+                return NanTypeError("The rows must be an array of arrays of parameter values");
+
+            auto rows = args[1].As<Array>();
+            if (rows->Length() == 0)
+                return NanRangeError("There must be at least one row of parameters");
+
+            if (!rows->Get(0)->IsArray())
+                return NanTypeError("The rows must be an array of arrays of parameter values");
+
+            auto paramCount = rows->Get(0).As<Array>()->Length();
+            if (paramCount == 0 || paramCount > USHRT_MAX)
+                return NanRangeError("The number of parameters must be between 1 and 65535");
+
+            for (uint32_t i = 1; i < rows->Length(); i++) {
+                auto row = rows->Get(i);
+                if (!row->IsArray() || row.As<Array>()->Length() != paramCount)
+                    return NanError("Every row must have the same number of parameters");
+            }
+
+            Handle<Array> types;
+            if (args.Length() > 3 && !args[2]->IsUndefined() && !args[2]->IsNull()) {
+                if (!args[2]->IsArray() || args[2].As<Array>()->Length() != paramCount)
+                    return NanTypeError("The types must be an array with one element for each parameter");
+                types = args[2].As<Array>();
+            }
+
+            auto params = new(nothrow) ParameterArray(rows->Length());
+            if (!params)
+                return NanError("Out of memory allocating the parameter array");
+
+            for (uint32_t i = 0; i < paramCount; i++) {
+                SQLSMALLINT sqlType = 0, decimalDigits = 0;
+                SQLULEN columnSize = 0;
+
+                // Each type is either an SQL type, or { type, columnSize, decimalDigits }.
+                // If no type is given, the parameter's description is used if the statement
+                // was prepared with describeParams, or else it is inferred from the values.
+                Handle<Value> type = types.IsEmpty() ? NanUndefined() : types->Get(i);
+                if (type->IsObject()) {
+                    auto desc = type.As<Object>();
+                    type = desc->Get(NanSymbol("type"));
+                    columnSize = desc->Get(NanSymbol("columnSize"))->Uint32Value();
+                    decimalDigits = static_cast<SQLSMALLINT>(desc->Get(NanSymbol("decimalDigits"))->Int32Value());
+                }
+
+                if (type->IsInt32()) {
+                    sqlType = static_cast<SQLSMALLINT>(type->Int32Value());
+                } else if (auto desc = (type->IsUndefined() || type->IsNull()) ? owner->GetParameterDescription(i + 1) : nullptr) {
+                    sqlType = desc->sqlType;
+                    if (!columnSize)
+                        columnSize = desc->columnSize;
+                    if (!decimalDigits)
+                        decimalDigits = desc->decimalDigits;
+                } else if (type->IsUndefined() || type->IsNull()) {
+                    sqlType = InferColumnType(rows, i);
+                    if (!sqlType) {
+                        delete params;
+
+                        char message[128];
+                        sprintf(message, "The values of parameter %u have different types, so its type must be given", i + 1);
+                        return NanTypeError(message);
+                    }
+                } else {
+                    delete params;
+                    return NanTypeError("Each type must be an SQL type, or an object with a type");
+                }
+
+                if (auto msg = params->AddColumn(sqlType, columnSize, decimalDigits, rows, i)) {
+                    delete params;
+                    return NanError(msg);
+                }
+            }
+
+            // Any parameters bound individually would be replaced anyway.
+            // The parameters are bound now, so this cannot wait behind another operation 
+            // which may be using the current bindings.
+            if (owner->IsBusy()) {
+                delete params;
+                return NanError("executeBatch cannot be queued behind another operation on the statement");
+            }
+
+            if (!owner->ResetParameters() || !SQL_SUCCEEDED(params->Bind(owner->GetHandle()))) {
+                auto error = owner->GetLastError();
+                ParameterArray::Unbind(owner->GetHandle());
+                delete params;
+                return error;
+            }
+
+            (new ExecuteBatchOperation(params))->Wrap(args.Holder());
+
+            EOS_OPERATION_CONSTRUCTOR_RETURN();
+        }
+
+        static const char* Name() { return "ExecuteBatchOperation"; }
+
+    private:
+        // Infers the SQL type of a column from all of its non-null values. Integers are 
+        // widened to doubles if the column has both; any other mix of types returns 0.
+        static SQLSMALLINT InferColumnType(Handle<Array> rows, uint32_t column) {
+            SQLSMALLINT sqlType = 0;
+
+            for (uint32_t j = 0; j < rows->Length(); j++) {
+                auto value = rows->Get(j).As<Object>()->Get(column);
+                if (value->IsNull() || value->IsUndefined())
+                    continue;
+
+                auto valueType = GetSQLType(value);
+                if (!sqlType || valueType == sqlType)
+                    sqlType = valueType;
+                else if ((sqlType == SQL_INTEGER || sqlType == SQL_DOUBLE) && (valueType == SQL_INTEGER || valueType == SQL_DOUBLE))
+                    sqlType = SQL_DOUBLE;
+                else
+                    return 0;
+            }
+
+            return sqlType ? sqlType : SQL_WVARCHAR;
+        }
+
+    protected:
+        SQLRETURN CallOverride() {
+            EOS_DEBUG_METHOD();
+
+            return SQLExecute(Owner()->GetHandle());
+        }
+
+        void CallbackOverride(SQLRETURN ret) {
+            EOS_DEBUG_METHOD();
+
+            EOS_DEBUG(L"Final Result: %hi\n", ret);
+
+            // The statuses are still useful when some of the rows failed, so they are 
+            // passed along with the error. 
+            Handle<Value> argv[] = { 
+                SQL_SUCCEEDED(ret) || ret == SQL_NO_DATA ? NanUndefined() : Owner()->GetLastError(),
+                params_->GetStatuses(),
+                NanNew<Number>(static_cast<double>(params_->ParamsProcessed()))
+            };
+
+            if (!SQL_SUCCEEDED(ParameterArray::Unbind(Owner()->GetHandle())))
+                EOS_DEBUG(L"Failed to restore the statement's parameter set size");
+
+            delete params_;
+            params_ = nullptr;
+            
+            MakeCallback(argv);
+        }
+
+    private:
+        ParameterArray* params_;
+    };
+}
+
+NAN_METHOD(Statement::ExecuteBatch) {
+    EOS_DEBUG_METHOD();
+
+    if (args.Length() < 1)
+        return NanThrowError("Statement::ExecuteBatch() requires an array of rows");
+
+    // The types may be given without a callback, to return a promise.
+    if (args.Length() < 2 || (args.Length() == 2 && args[1]->IsFunction())) {
+        Handle<Value> argv[] = { NanObjectWrapHandle(this), args[0], args[1] };
+        return Begin<ExecuteBatchOperation>(argv);
+    }
+
+    Handle<Value> argv[] = { NanObjectWrapHandle(this), args[0], args[1], args[2] };
+    return Begin<ExecuteBatchOperation>(argv);
+}
+
+template<> Persistent<FunctionTemplate> Operation<Statement, ExecuteBatchOperation>::constructor_ = Persistent<FunctionTemplate>();
+namespace { ClassInitializer<ExecuteBatchOperation> ci; }
@@ -0,0 +1,192 @@
+#include "stmt.hpp"
+#include "paramarray.hpp"
+
+using namespace Eos;
+
+namespace Eos {
+    struct ExecuteColumnsOperation : Operation<Statement, ExecuteColumnsOperation> {
+        ExecuteColumnsOperation(ParameterArray* params, Handle<Array> pinned)
+            : params_(params)
+        {
+            EOS_DEBUG_METHOD();
+
+            // The typed arrays are bound directly, so they must outlive the operation.
+            NanAssignPersistent(pinned_, pinned);
+        }
+
+        ~ExecuteColumnsOperation() {
+            EOS_DEBUG_METHOD();
+
+            delete params_;
+
+            if (!pinned_.IsEmpty())
+                NanDisposePersistent(pinned_);
+        }
+
+        static EOS_OPERATION_CONSTRUCTOR(New, Statement) {
+            EOS_DEBUG_METHOD();
+
+            if (args.Length() < 2)
+                return NanError("Too few arguments");
+
+            if (!args[1]->IsArray())
+                return NanTypeError("The columns must be an array of objects with a type and values");
+
+            auto columns = args[1].As<Array>();
+            if (columns->Length() == 0 || columns->Length() > USHRT_MAX)
+                return NanRangeError("The number of columns must be between 1 and 65535");
+
+            auto pinned = NanNew<Array>();
+            ParameterArray* params = nullptr;
+            SQLLEN rowCount = -1;
+
+            for (uint32_t i = 0; i < columns->Length(); i++) {
+                // { type, values, [nulls], [columnSize], [decimalDigits] }
+                if (!columns->Get(i)->IsObject()) {
+                    delete params;
+                    return NanTypeError("Each column must be an object with a type and values");
+                }
+
+                auto column = columns->Get(i).As<Object>();
+                auto type = column->Get(NanSymbol("type"));
+                auto values = column->Get(NanSymbol("values"));
+                auto nulls = column->Get(NanSymbol("nulls"));
+                auto columnSize = column->Get(NanSymbol("columnSize"))->Uint32Value();
+                auto decimalDigits = static_cast<SQLSMALLINT>(column->Get(NanSymbol("decimalDigits"))->Int32Value());
+
+                SQLPOINTER data = nullptr;
+                SQLLEN length = 0;
+                auto cType = UnwrapTypedArray(values, data, length);
+                if (cType < 0) {
+                    delete params;
+                    return NanTypeError("The typed array of a column has no backing store");
+                }
+
+                if (!cType) {
+                    if (!values->IsArray()) {
+                        delete params;
+                        return NanTypeError("The values of each column must be an Int32Array, a Float64Array or an Array");
+                    }
+                    length = values.As<Array>()->Length();
+                }
+
+                if (!type->IsInt32() && !(cType && type->IsUndefined())) {
+                    delete params;
+                    return NanTypeError("Each column must have an SQL type");
+                }
+
+                if (rowCount < 0) {
+                    rowCount = length;
+                    if (rowCount == 0)
+                        return NanRangeError("There must be at least one row of parameters");
+
+                    params = new(nothrow) ParameterArray(rowCount);
+                    if (!params)
+                        return NanError("Out of memory allocating the parameter array");
+                } else if (length != rowCount) {
+                    delete params;
+                    return NanRangeError("Every column must have the same number of values");
+                }
+
+                const char* msg;
+
+                if (cType) {
+                    SQLSMALLINT sqlType = type->IsInt32() 
+                        ? static_cast<SQLSMALLINT>(type->Int32Value()) 
+                        : cType == SQL_C_SLONG ? SQL_INTEGER : SQL_DOUBLE;
+
+                    SQLPOINTER nullBitmap = nullptr;
+                    if (!nulls->IsUndefined() && !nulls->IsNull()) {
+                        SQLLEN bitmapLength;
+                        if (!JSBuffer::HasInstance(nulls) 
+                            || JSBuffer::Unwrap(nulls.As<Object>(), nullBitmap, bitmapLength)
+                            || bitmapLength < (rowCount + 7) / 8) 
+                        {
+                            delete params;
+                            return NanTypeError("The nulls of each column must be a Buffer with one bit per value");
+                        }
+                    }
+
+                    pinned->Set(pinned->Length(), values);
+                    msg = params->AddExternalColumn(
+                        sqlType, cType, decimalDigits, data, 
+                        reinterpret_cast<const unsigned char*>(nullBitmap));
+                } else {
+                    msg = params->AddColumn(
+                        static_cast<SQLSMALLINT>(type->Int32Value()), columnSize, decimalDigits,
+                        values.As<Array>(), -1);
+                }
+
+                if (msg) {
+                    delete params;
+                    return NanError(msg);
+                }
+            }
+
+            // The parameters are bound now, so this cannot wait behind another operation 
+            // which may be using the current bindings.
+            if (owner->IsBusy()) {
+                delete params;
+                return NanError("executeColumns cannot be queued behind another operation on the statement");
+            }
+
+            if (!owner->ResetParameters() || !SQL_SUCCEEDED(params->Bind(owner->GetHandle()))) {
+                auto error = owner->GetLastError();
+                ParameterArray::Unbind(owner->GetHandle());
+                delete params;
+                return error;
+            }
+
+            (new ExecuteColumnsOperation(params, pinned))->Wrap(args.Holder());
+
+            EOS_OPERATION_CONSTRUCTOR_RETURN();
+        }
+
+        static const char* Name() { return "ExecuteColumnsOperation"; }
+
+    protected:
+        SQLRETURN CallOverride() {
+            EOS_DEBUG_METHOD();
+
+            return SQLExecute(Owner()->GetHandle());
+        }
+
+        void CallbackOverride(SQLRETURN ret) {
+            EOS_DEBUG_METHOD();
+
+            EOS_DEBUG(L"Final Result: %hi\n", ret);
+
+            Handle<Value> argv[] = { 
+                SQL_SUCCEEDED(ret) || ret == SQL_NO_DATA ? NanUndefined() : Owner()->GetLastError(),
+                params_->GetStatuses(),
+                NanNew<Number>(static_cast<double>(params_->ParamsProcessed()))
+            };
+
+            if (!SQL_SUCCEEDED(ParameterArray::Unbind(Owner()->GetHandle())))
+                EOS_DEBUG(L"Failed to restore the statement's parameter set size");
+
+            delete params_;
+            params_ = nullptr;
+            NanDisposePersistent(pinned_);
+            
+            MakeCallback(argv);
+        }
+
+    private:
+        ParameterArray* params_;
+        Persistent<Array> pinned_;
+    };
+}
+
+NAN_METHOD(Statement::ExecuteColumns) {
+    EOS_DEBUG_METHOD();
+
+    if (args.Length() < 1)
+        return NanThrowError("Statement::ExecuteColumns() requires an array of columns");
+
+    Handle<Value> argv[] = { NanObjectWrapHandle(this), args[0], args[1] };
+    return Begin<ExecuteColumnsOperation>(argv);
+}
+
+template<> Persistent<FunctionTemplate> Operation<Statement, ExecuteColumnsOperation>::constructor_ = Persistent<FunctionTemplate>();
+namespace { ClassInitializer<ExecuteColumnsOperation> ci; }
@@ -50,11 +50,13 @@ namespace Eos {
 NAN_METHOD(Statement::Fetch) {
     EOS_DEBUG_METHOD();
 
-    if (args.Length() < 1)
-        return NanThrowError("Statement::Fetch() requires a callback");
+    if (!IOperation::IsCallback(args[0]))
+        return NanThrowTypeError("Last argument should be a callback function");
 
-    Handle<Value> argv[] = { NanObjectWrapHandle(this), args[0] };
-    return Begin<FetchOperation>(argv);
+    if (auto msg = CheckCanBegin())
+        return NanThrowError(msg);
+
+    return BeginPooled(FetchOperation::Acquire(this, args[0]));
 }
 
 template<> Persistent<FunctionTemplate> Operation<Statement, FetchOperation>::constructor_ = Persistent<FunctionTemplate>();
@@ -0,0 +1,90 @@
+#include "stmt.hpp"
+#include "result.hpp"
+
+using namespace Eos;
+
+namespace Eos {
+    struct FetchBlockOperation : Operation<Statement, FetchBlockOperation> {
+        FetchBlockOperation(ResultBlock* block)
+            : block_(block)
+        {
+            EOS_DEBUG_METHOD();
+
+            block_->SetBusy(true);
+        }
+
+        static EOS_OPERATION_CONSTRUCTOR(New, Statement) {
+            EOS_DEBUG_METHOD();
+
+            if (args.Length() < 1)
+                return NanError("Too few arguments");
+
+            auto block = owner->GetResultBlock();
+            if (!block)
+                return NanError("No block has been bound (call bindBlock first)");
+
+            if (block->IsBusy())
+                return NanError("A block fetch is already in progress");
+
+            (new FetchBlockOperation(block))->Wrap(args.Holder());
+
+            EOS_OPERATION_CONSTRUCTOR_RETURN();
+        }
+
+        void CallbackOverride(SQLRETURN ret) {
+            EOS_DEBUG_METHOD();
+
+            block_->SetBusy(false);
+
+            if (!SQL_SUCCEEDED(ret) && ret != SQL_NO_DATA)
+                return CallbackErrorOverride(ret);
+
+            EOS_DEBUG(L"Final Result: %hi\n", ret);
+
+            if (ret == SQL_NO_DATA) {
+                Handle<Value> argv[] = { NanUndefined(), NanNew<Number>(0) };
+                return MakeCallback(argv);
+            }
+
+            auto values = NanNew<Array>(), nulls = NanNew<Array>();
+
+            TryCatch tc;
+            if (!block_->Convert(values, nulls)) {
+                Handle<Value> argv[] = { tc.Exception() };
+                return MakeCallback(argv);
+            }
+
+            Handle<Value> argv[] = { 
+                NanUndefined(),
+                NanNew<Number>(static_cast<double>(block_->RowsFetched())),
+                values,
+                nulls
+            };
+            
+            MakeCallback(argv);
+        }
+
+        static const char* Name() { return "FetchBlockOperation"; }
+
+    protected:
+        SQLRETURN CallOverride() {
+            EOS_DEBUG_METHOD();
+
+            return SQLFetch(
+                Owner()->GetHandle());
+        }
+
+    private:
+        ResultBlock* block_;
+    };
+}
+
+NAN_METHOD(Statement::FetchBlock) {
+    EOS_DEBUG_METHOD();
+
+    Handle<Value> argv[] = { NanObjectWrapHandle(this), args[0] };
+    return Begin<FetchBlockOperation>(argv);
+}
+
+template<> Persistent<FunctionTemplate> Operation<Statement, FetchBlockOperation>::constructor_ = Persistent<FunctionTemplate>();
+namespace { ClassInitializer<FetchBlockOperation> ci; }
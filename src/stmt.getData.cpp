@@ -1,4 +1,5 @@
 #include "stmt.hpp"
+#include "decoder.hpp"
 #include <ctime>
 #include <climits>
 
@@ -6,26 +7,40 @@ using namespace Eos;
 
 namespace Eos {
     struct GetDataOperation : Operation<Statement, GetDataOperation> {
-        GetDataOperation
-            ( SQLUSMALLINT columnNumber
-            , SQLSMALLINT sqlType
-            , SQLPOINTER buffer
-            , SQLLEN bufferLength
-            , Handle<Object> bufferHandle
-            , bool raw
-            )
-            : columnNumber_(columnNumber)
-            , sqlType_(sqlType)
-            , buffer_(buffer)
-            , bufferLength_(bufferLength)
+        GetDataOperation() 
+            : buffer_(nullptr)
+            , bufferLength_(0)
             , totalLength_(0)
-            , raw_(raw)
         {
-            EOS_DEBUG_METHOD_FMT(L"%hu, type = %hi", columnNumber_, sqlType_);
+            EOS_DEBUG_METHOD();
+        }
+
+        struct Arguments {
+            SQLUSMALLINT columnNumber;
+            SQLSMALLINT sqlType;
+            SQLPOINTER buffer;
+            SQLLEN bufferLength;
+            Handle<Object> bufferHandle;
+            bool raw;
+        };
+
+        // Called once for each use, since GetDataOperations are pooled.
+        void Initialize(const Arguments& a, int convertOptions) {
+            EOS_DEBUG_METHOD_FMT(L"%hu, type = %hi", a.columnNumber, a.sqlType);
 
-            NanAssignPersistent(bufferHandle_, bufferHandle);
+            columnNumber_ = a.columnNumber;
+            sqlType_ = a.sqlType;
+            buffer_ = a.buffer;
+            bufferLength_ = a.bufferLength;
+            totalLength_ = 0;
+            raw_ = a.raw;
+
+            assert(bufferHandle_.IsEmpty());
+            if (!a.bufferHandle.IsEmpty())
+                NanAssignPersistent(bufferHandle_, a.bufferHandle);
 
             cType_ = GetCTypeForSQLType(sqlType_);
+            decoder_ = GetDecoder(cType_, convertOptions);
 
             if (buffer_ == nullptr) {
                 assert(bufferHandle_.IsEmpty());
@@ -54,57 +69,69 @@ namespace Eos {
             }
         }
 
-        static EOS_OPERATION_CONSTRUCTOR(New, Statement) {
-            EOS_DEBUG_METHOD();
-
-            if (args.Length() < 6)
-                return NanError("Too few arguments");
-
-            auto columnNumber = args[1]->Int32Value();
-            auto sqlType = args[2]->Int32Value();
+        // Validates the arguments (column number, target type, buffer, raw), starting at 
+        // args[first]. Returns an error message on failure.
+        static const char* ParseArguments(_NAN_METHOD_ARGS_TYPE args, int first, Arguments& result) {
+            auto columnNumber = args[first]->Int32Value();
+            auto sqlType = args[first + 1]->Int32Value();
 
-            if (!args[1]->IsUint32() || columnNumber > USHRT_MAX)
-                return NanError("Column number must be an integer from 0 to 65535");
+            if (!args[first]->IsUint32() || columnNumber > USHRT_MAX)
+                return "Column number must be an integer from 0 to 65535";
 
-            if (!args[2]->IsInt32() || sqlType < SHRT_MIN || sqlType > SHRT_MAX)
-                return NanError("Target type is out of range");
+            if (!args[first + 1]->IsInt32() || sqlType < SHRT_MIN || sqlType > SHRT_MAX)
+                return "Target type is out of range";
 
+            auto bufferArg = args[first + 2];
             Handle<Object> bufferHandle;
             SQLPOINTER buffer;
             SQLLEN bufferLength;
-            bool raw;
-            bool ownBuffer;
 
 #if !defined(NODE_12)
-            if (args[3]->IsObject() && args[3].As<Object>()->GetConstructor()->Equals(JSBuffer::Constructor())) {
-                bufferHandle = args[3].As<Object>();
+            if (bufferArg->IsObject() && bufferArg.As<Object>()->GetConstructor()->Equals(JSBuffer::Constructor())) {
+                bufferHandle = bufferArg.As<Object>();
                 
                 auto msg = JSBuffer::Unwrap(bufferHandle, buffer, bufferLength);
                 if (msg)
-                    return NanError(msg);
+                    return msg;
             } else 
 #endif
-            if (args[3]->IsObject() && Buffer::HasInstance(args[3])) {
-                buffer = Buffer::Data(args[3]);
-                bufferLength = Buffer::Length(args[3]);
-                ownBuffer = false;
+            if (bufferArg->IsObject() && Buffer::HasInstance(bufferArg)) {
+                // Kept alive while the driver writes into it.
+                bufferHandle = bufferArg.As<Object>();
+                buffer = Buffer::Data(bufferArg);
+                bufferLength = Buffer::Length(bufferArg);
             } else {
-                if (!args[3]->IsUndefined() && !args[3]->IsNull())
-                    return NanError("Unknown buffer type (pass null to have a buffer created automatically)");
+                if (!bufferArg->IsUndefined() && !bufferArg->IsNull())
+                    return "Unknown buffer type (pass null to have a buffer created automatically)";
 
                 // The operation can choose to allocate a buffer if it decides it necessary
                 // based on targetType.
                 buffer = nullptr;
                 bufferLength = 0;
             }
-            
-            raw = args[4]->BooleanValue();
 
-            (new GetDataOperation(
-                columnNumber, 
-                sqlType, 
-                buffer, bufferLength, bufferHandle,
-                raw))->Wrap(args.Holder());
+            result.columnNumber = static_cast<SQLUSMALLINT>(columnNumber);
+            result.sqlType = static_cast<SQLSMALLINT>(sqlType);
+            result.buffer = buffer;
+            result.bufferLength = bufferLength;
+            result.bufferHandle = bufferHandle;
+            result.raw = args[first + 3]->BooleanValue();
+            return nullptr;
+        }
+
+        static EOS_OPERATION_CONSTRUCTOR(New, Statement) {
+            EOS_DEBUG_METHOD();
+
+            if (args.Length() < 6)
+                return NanError("Too few arguments");
+
+            Arguments arguments;
+            if (auto msg = ParseArguments(args, 1, arguments))
+                return NanError(msg);
+
+            auto op = new GetDataOperation();
+            op->Initialize(arguments, owner->ConversionOptions());
+            op->Wrap(args.Holder());
 
             EOS_OPERATION_CONSTRUCTOR_RETURN();
         }
@@ -144,7 +171,7 @@ namespace Eos {
                 else
                     argv[1] = JSBuffer::Slice(NanNew(bufferHandle_), 0, totalLength_);
             } else {
-                argv[1] = Eos::ConvertToJS(buffer_, totalLength_, bufferLength_, cType_);
+                argv[1] = decoder_(buffer_, totalLength_, bufferLength_);
                 if (argv[1]->IsUndefined())
                     argv[0] = OdbcError("Unable to interpret contents of result buffer");
             }
@@ -184,17 +211,31 @@ namespace Eos {
         } rawValues_;
 
         bool raw_;
+        Decoder decoder_;
     };
 }
 
 NAN_METHOD(Statement::GetData) {
     EOS_DEBUG_METHOD();
 
-    if (args.Length() < 5)
-        return NanThrowError("Statement::GetData() requires 4 arguments and a callback");
+    if (args.Length() < 4)
+        return NanThrowError("Statement::GetData() requires 4 arguments");
+
+    if (!IOperation::IsCallback(args[4]))
+        return NanThrowTypeError("Last argument should be a callback function");
+
+    if (auto msg = CheckCanBegin())
+        return NanThrowError(msg);
+
+    GetDataOperation::Arguments arguments;
+    if (auto msg = GetDataOperation::ParseArguments(args, 0, arguments))
+        return NanThrowError(msg);
+
+    auto op = GetDataOperation::Acquire(this, args[4]);
+    if (op)
+        op->Initialize(arguments, ConversionOptions());
 
-    Handle<Value> argv[] = { NanObjectWrapHandle(this), args[0], args[1], args[2], args[3], args[4] };
-    return Begin<GetDataOperation>(argv);
+    return BeginPooled(op);
 }
 
 template<> Persistent<FunctionTemplate> Operation<Statement, GetDataOperation>::constructor_ = Persistent<FunctionTemplate>();
@@ -4,8 +4,19 @@
 #include "conn.hpp"
 #include "handle.hpp"
 
+#include <vector>
+
 namespace Eos {
     struct Parameter;
+    struct ResultBlock;
+
+    // The type of a parameter of a prepared statement, as returned by SQLDescribeParam.
+    struct ParameterDescription {
+        SQLSMALLINT sqlType;
+        SQLULEN columnSize;
+        SQLSMALLINT decimalDigits;
+        SQLSMALLINT nullable;
+    };
 
     struct Statement: EosHandle {
         static void Init(Handle<Object> exports);
@@ -20,6 +31,8 @@ namespace Eos {
 
     protected:
         void VirtualFree();
+        NAN_METHOD(BeginFree);
+        bool Recycle();
 
     public:
 
@@ -27,6 +40,8 @@ namespace Eos {
         NAN_METHOD(Prepare);
         NAN_METHOD(ExecDirect);
         NAN_METHOD(Execute);
+        NAN_METHOD(ExecuteBatch);
+        NAN_METHOD(ExecuteColumns);
         NAN_METHOD(Fetch);
         NAN_METHOD(GetData);
         NAN_METHOD(Cancel);
@@ -35,34 +50,118 @@ namespace Eos {
 
         NAN_METHOD(ParamData);
         NAN_METHOD(PutData);
+        NAN_METHOD(PutDataStream);
         NAN_METHOD(MoreResults);
         
         NAN_METHOD(BindParameter);
         NAN_METHOD(SetParameterName);
         NAN_METHOD(UnbindParameters);
+        NAN_METHOD(BindParameters);
 
         NAN_METHOD(BindCol);
         NAN_METHOD(UnbindColumn);
         NAN_METHOD(UnbindColumns);
 
+        NAN_METHOD(BindBlock);
+        NAN_METHOD(FetchBlock);
+        NAN_METHOD(UnbindBlock);
+
         NAN_METHOD(CloseCursor);
+        NAN_METHOD(Release);
+
+        NAN_GETTER(GetTimestampsAsNumbers) const;
+        NAN_SETTER(SetTimestampsAsNumbers);
+
+        NAN_GETTER(GetParameterDescriptions) const;
+        NAN_GETTER(GetAsyncPolling) const;
+
+        NAN_GETTER(GetTimeout) const;
+        NAN_SETTER(SetTimeout);
 
     public:
 
         // Non-JS methods
         static Handle<FunctionTemplate> Constructor() { return NanNew(constructor_); }
 
+        // The ConvertOptions flags to use for values retrieved from this statement.
+        int ConversionOptions() const { return convertOptions_; }
+
+        // The cached description of a parameter (numbered from 1), if the statement was 
+        // prepared with describeParams set, or nullptr.
+        const ParameterDescription* GetParameterDescription(SQLUSMALLINT parameterNumber) const {
+            if (parameterNumber < 1 || parameterNumber > paramDescriptions_.size())
+                return nullptr;
+            return &paramDescriptions_[parameterNumber - 1];
+        }
+
+        void SetParameterDescriptions(std::vector<ParameterDescription>& descriptions) {
+            paramDescriptions_.swap(descriptions);
+        }
+
+        // Unbinds all parameters (SQL_RESET_PARAMS). Returns false on failure.
+        bool ResetParameters();
+
+        // The columns bound by bindBlock, or nullptr.
+        ResultBlock* GetResultBlock() const { return resultBlock_; }
+
+        // Called by the connection if it is destroyed first.
+        void ConnectionDestroyed();
+
+        // The statement's connection, or nullptr if it has been destroyed.
+        Connection* GetConnection() const { return connection_; }
+
+        WorkerPool::Lane Priority() const;
+        bool CheckPriorityChange();
+
+        // Forgets the statement's bindings and gives up its handle, for the connection to 
+        // free. Returns SQL_NULL_HANDLE if it has already been freed.
+        SQLHSTMT TakeHandle();
+
+        // The SQL the statement was last prepared with, by prepare(), prepareCached() or
+        // autoPrepare, or empty if it has none (e.g. after execDirect()). It is set by the
+        // operations' callbacks, when no operation is running, so the operations can read it
+        // on the worker thread; on the main thread, it is only current while the statement
+        // is not busy.
+        const SqlText& PreparedSql() const { return preparedSql_; }
+        void SetPreparedSql(const SqlText& sql, bool autoPrepared = false) { 
+            preparedSql_ = sql; 
+            autoPrepared_ = autoPrepared;
+        }
+
+        // For execDirect() with autoPrepare: if the statement is idle and has nothing bound,
+        // and the statement cache has a statement with sql prepared, swaps handles with it
+        // and discards it, so that the SQL need not be prepared again. Returns true if it 
+        // did; the cursor the cached statement left open, if any, still has to be closed.
+        bool AdoptCachedStatement(const SqlText& sql);
+
+        // Closes the cursor of a statement handed out by the statement cache, on its worker 
+        // thread, then calls back with the statement. Takes prepareCached()'s arguments.
+        NAN_METHOD(BeginReuse);
+
+        // Frees the handle in the background, for statements which are released but not 
+        // cached.
+        void Discard();
+
     protected:
         
         void AddBoundColumn(Parameter* col);
         void AddBoundParameter(Parameter* param);
         Parameter* GetBoundParameter(SQLUSMALLINT parameterNumber);
+        const char* FreeResultBlock();
+        void ForgetParameterBindings();
+        void DetachParameterBlock();
 
     private:
         Persistent<Array> boundParameters_;
+        Persistent<Object> parameterBlock_;
         Persistent<Array> boundColumns_;
 
         Connection* connection_;
+        int convertOptions_;
+        ResultBlock* resultBlock_;
+        std::vector<ParameterDescription> paramDescriptions_;
+        SqlText preparedSql_;
+        bool autoPrepared_;
 
         static Persistent<FunctionTemplate> constructor_;
     };
@@ -51,9 +51,6 @@ namespace Eos {
 NAN_METHOD(Statement::MoreResults) {
     EOS_DEBUG_METHOD();
 
-    if (args.Length() < 1)
-        return NanThrowError("Statement::MoreResults() requires a callback");
-
     Handle<Value> argv[] = { NanObjectWrapHandle(this), args[0] };
     return Begin<MoreResultsOperation>(argv);
 }
@@ -54,9 +54,6 @@ namespace Eos {
 NAN_METHOD(Statement::NumResultCols) {
     EOS_DEBUG_METHOD();
 
-    if (args.Length() < 1)
-        return NanThrowError("Statement::NumResultCols() requires a callback");
-
     Handle<Value> argv[] = { NanObjectWrapHandle(this), args[0] };
     return Begin<NumResultColsOperation>(argv);
 }
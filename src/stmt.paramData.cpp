@@ -60,9 +60,6 @@ namespace Eos {
 NAN_METHOD(Statement::ParamData) {
     EOS_DEBUG_METHOD();
 
-    if (args.Length() < 1)
-        return NanThrowError("Statement::ParamData() requires a callback");
-
     Handle<Value> argv[] = { NanObjectWrapHandle(this), args[0] };
     return Begin<ParamDataOperation>(argv);
 }
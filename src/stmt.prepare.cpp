@@ -4,8 +4,12 @@ using namespace Eos;
 
 namespace Eos {
     struct PrepareOperation : Operation<Statement, PrepareOperation> {
-        PrepareOperation(Handle<Value> sql)
+        // SQLPrepare may be followed by SQLDescribeParam calls.
+        enum { Pollable = false };
+
+        PrepareOperation(Handle<Value> sql, bool describeParams)
             : sql_(sql)
+            , describeParams_(describeParams)
         {
             EOS_DEBUG_METHOD_FMT(L"sql = %ls", *sql_);
         }
@@ -19,32 +23,93 @@ namespace Eos {
             if (!args[1]->IsString())
                 return NanTypeError("Statement SQL should be a string");
 
-            (new PrepareOperation(args[1]))->Wrap(args.Holder());
+            bool describeParams = args.Length() > 3 && args[2]->BooleanValue();
+
+            (new PrepareOperation(args[1], describeParams))->Wrap(args.Holder());
 
             EOS_OPERATION_CONSTRUCTOR_RETURN();
         }
 
+        void CallbackOverride(SQLRETURN ret) {
+            EOS_DEBUG_METHOD();
+
+            // The descriptions and SQL are replaced here, rather than when the operation is 
+            // begun, as operations queued before this one may still rely on them. If the 
+            // prepare failed, nothing is prepared any more.
+            Owner()->SetParameterDescriptions(descriptions_);
+
+            if (!SQL_SUCCEEDED(ret)) {
+                Owner()->SetPreparedSql(SqlText());
+                return CallbackErrorOverride(ret);
+            }
+
+            Owner()->SetPreparedSql(SqlText(*sql_, sql_.length()));
+            MakeCallback(0, nullptr);
+        }
+
         static const char* Name() { return "PrepareOperation"; }
 
     protected:
         SQLRETURN CallOverride() {
             EOS_DEBUG_METHOD();
 
-            return SQLPrepareW(
-                Owner()->GetHandle(), 
+            auto hStmt = Owner()->GetHandle();
+
+            auto ret = SQLPrepareW(
+                hStmt, 
                 *sql_, sql_.length());
+
+            if (SQL_SUCCEEDED(ret) && describeParams_)
+                DescribeParams(hStmt);
+
+            return ret;
+        }
+
+        // Not all drivers support SQLDescribeParam, so if it fails, the parameters are
+        // simply left undescribed.
+        void DescribeParams(SQLHSTMT hStmt) {
+            SQLSMALLINT count;
+            if (!SQL_SUCCEEDED(SQLNumParams(hStmt, &count)))
+                return;
+
+            descriptions_.resize(count);
+
+            for (SQLSMALLINT i = 0; i < count; i++) {
+                auto& desc = descriptions_[i];
+                auto ret = SQLDescribeParam(
+                    hStmt, 
+                    i + 1, 
+                    &desc.sqlType, 
+                    &desc.columnSize, 
+                    &desc.decimalDigits, 
+                    &desc.nullable);
+
+                if (!SQL_SUCCEEDED(ret)) {
+                    EOS_DEBUG(L"SQLDescribeParam failed for parameter %i\n", i + 1);
+                    descriptions_.clear();
+                    return;
+                }
+            }
         }
 
     protected:
         WStringValue sql_;
+        bool describeParams_;
+        std::vector<ParameterDescription> descriptions_;
     };
 }
 
 NAN_METHOD(Statement::Prepare) {
     EOS_DEBUG_METHOD();
 
-    if (args.Length() < 2)
-        return NanThrowError("Statement::Prepare() requires 2 arguments");
+    if (args.Length() < 1)
+        return NanThrowError("Statement::Prepare() requires an SQL string");
+
+    // describeParams may be given without a callback, to return a promise.
+    if (args.Length() > 2 || (args.Length() == 2 && !args[1]->IsFunction())) {
+        Handle<Value> argv[] = { NanObjectWrapHandle(this), args[0], args[1], args[2] };
+        return Begin<PrepareOperation>(argv);
+    }
 
     Handle<Value> argv[] = { NanObjectWrapHandle(this), args[0], args[1] };
     return Begin<PrepareOperation>(argv);
@@ -0,0 +1,203 @@
+#include "stmt.hpp"
+#include "parameter.hpp"
+#include "datasink.hpp"
+
+using namespace Eos;
+
+namespace Eos {
+    // Sends every chunk written to a DataSink with SQLPutData, then calls SQLParamData.
+    // Each trip to the thread pool sends the chunks which have been queued so far; if the
+    // stream has not ended, the operation is submitted again once more data is written.
+    struct PutDataStreamOperation : Operation<Statement, PutDataStreamOperation>, DataSink::Reader {
+        enum { Pollable = false, AsyncCapable = false };
+
+        PutDataStreamOperation(Parameter* param, Handle<Object> sinkObject, uv_loop_t* loop)
+            : parameter_(param)
+            , sink_(DataSink::Unwrap(sinkObject))
+            , nextParameter_(nullptr)
+            , sentAny_(false)
+            , waiting_(false)
+            , aborted_(false)
+            , cancelled_(false)
+        {
+            EOS_DEBUG_METHOD();
+
+            NanAssignPersistent(sinkObject_, sinkObject);
+            sink_->Open(loop);
+        }
+
+        ~PutDataStreamOperation() {
+            EOS_DEBUG_METHOD();
+
+            if (!sinkObject_.IsEmpty())
+                NanDisposePersistent(sinkObject_);
+        }
+
+        static EOS_OPERATION_CONSTRUCTOR(New, Statement) {
+            EOS_DEBUG_METHOD();
+
+            if (args.Length() < 3)
+                return NanError("Too few arguments");
+
+            if (!Parameter::Constructor()->HasInstance(args[1]))
+                return NanTypeError("The first parameter should be a Parameter");
+
+            if (!DataSink::Constructor()->HasInstance(args[2]))
+                return NanTypeError("Bad argument");
+
+            auto param = Parameter::Unwrap(args[1].As<Object>());
+            param->Ref();
+
+            (new PutDataStreamOperation(param, args[2].As<Object>(), owner->Pool()->Loop()))->Wrap(args.Holder());
+
+            EOS_OPERATION_CONSTRUCTOR_RETURN();
+        }
+
+        void CallbackOverride(SQLRETURN ret) {
+            EOS_DEBUG_METHOD();
+
+            parameter_->Unref();
+
+            sink_->Close();
+            NanDisposePersistent(sinkObject_);
+
+            if (aborted_) {
+                Handle<Value> argv[] = { NanError("The stream was aborted") };
+                return MakeCallback(argv);
+            }
+
+            if (cancelled_) {
+                Handle<Value> argv[] = { OdbcError(NanNew<String>("The operation timed out and was cancelled"), NanNew<String>("HY008")) };
+                return MakeCallback(argv);
+            }
+
+            if (!SQL_SUCCEEDED(ret) && ret != SQL_NO_DATA && ret != SQL_PARAM_DATA_AVAILABLE && ret != SQL_NEED_DATA)
+                return CallbackErrorOverride(ret);
+
+            EOS_DEBUG(L"Final Result: %hi\n", ret);
+
+            Handle<Value> argv[] = { 
+                NanUndefined(),
+                NanUndefined(),
+                NanNew<Boolean>(ret == SQL_NEED_DATA),
+                NanNew<Boolean>(ret == SQL_PARAM_DATA_AVAILABLE)
+            };
+
+            if ((ret == SQL_PARAM_DATA_AVAILABLE || ret == SQL_NEED_DATA) && nextParameter_)
+                argv[1] = NanObjectWrapHandle(reinterpret_cast<Parameter*>(nextParameter_));
+
+            MakeCallback(argv);
+        }
+
+        static const char* Name() { return "PutDataStreamOperation"; }
+
+        // Main thread: more data has been written to the sink since the last trip ran out.
+        void DataAvailable() {
+            EOS_DEBUG_METHOD();
+
+            auto owner = Owner();
+            owner->Pool()->Submit(owner->Affinity(), owner->Priority(), this);
+        }
+
+    protected:
+        SQLRETURN CallOverride() {
+            EOS_DEBUG_METHOD();
+
+            auto hStmt = Owner()->GetHandle();
+            DataSink::Chunk chunk;
+
+            for (;;) {
+                switch (sink_->Pop(chunk)) {
+                case DataSink::Popped: {
+                    auto ret = SQLPutData(hStmt, chunk.data, chunk.length);
+                    sink_->Release(chunk);
+                    sentAny_ = true;
+
+                    if (!SQL_SUCCEEDED(ret))
+                        return ret;
+                    continue;
+                }
+
+                case DataSink::Empty:
+                    // Give the thread back until more is written.
+                    waiting_ = true;
+                    return SQL_SUCCESS;
+
+                case DataSink::Aborted:
+                    // Abandon the data-at-execution sequence.
+                    aborted_ = true;
+                    return SQLCancel(hStmt);
+
+                case DataSink::Cancelled:
+                    // The watchdog cancelled the trip between two chunks.
+                    cancelled_ = true;
+                    return SQLCancel(hStmt);
+
+                case DataSink::Ended:
+                    break;
+                }
+
+                break;
+            }
+
+            // An empty stream is an empty value, rather than no value at all.
+            if (!sentAny_) {
+                auto ret = SQLPutData(hStmt, &chunk, 0);
+                if (!SQL_SUCCEEDED(ret))
+                    return ret;
+            }
+
+            return SQLParamData(hStmt, &nextParameter_);
+        }
+
+        // Watchdog thread: also stops the sink, so that a trip which is between chunks, or 
+        // which has more to send, ends instead of carrying on with the next one.
+        void Cancel() {
+            sink_->Cancel();
+            Operation<Statement, PutDataStreamOperation>::Cancel();
+        }
+
+        // The operation only completes once the stream has ended, been aborted or failed.
+        void Completed() {
+            if (waiting_) {
+                waiting_ = false;
+                if (sink_->Wait(this))
+                    return;
+                return DataAvailable();
+            }
+
+            Operation<Statement, PutDataStreamOperation>::Completed();
+        }
+
+    private:
+        Parameter* parameter_;
+        DataSink* sink_;
+        Persistent<Object> sinkObject_;
+        SQLPOINTER nextParameter_;
+        bool sentAny_, waiting_, aborted_, cancelled_;
+    };
+}
+
+NAN_METHOD(Statement::PutDataStream) {
+    EOS_DEBUG_METHOD();
+
+    if (args.Length() < 2)
+        return NanThrowError("Statement::PutDataStream() requires a parameter and a callback");
+
+    // The sink is returned instead of a promise, so the callback is the only way to see the
+    // operation complete or fail.
+    if (!args[1]->IsFunction())
+        return NanThrowTypeError("Statement::PutDataStream() requires a callback function");
+
+    auto sink = DataSink::New();
+    if (sink.IsEmpty())
+        return NanThrowError("Out of memory allocating the data sink");
+
+    Handle<Value> argv[] = { NanObjectWrapHandle(this), args[0], sink, args[1] };
+    Begin<PutDataStreamOperation>(argv);
+
+    EosMethodReturnValue(sink);
+}
+
+template<> Persistent<FunctionTemplate> Operation<Statement, PutDataStreamOperation>::constructor_ = Persistent<FunctionTemplate>();
+namespace { ClassInitializer<PutDataStreamOperation> ci; }